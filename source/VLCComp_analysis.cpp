@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_analysis.h"
+
+#include <algorithm>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+// GainAnalyzer
+//------------------------------------------------------------------------
+bool GainAnalyzer::setup(SampleRate SR, const CompParams& newParams, uint32 windowSamples)
+{
+    sampleRate = SR;
+    step       = 4 * detectorDecimation(SR);
+    window     = (std::max(windowSamples, step) + step - 1) / step * step;
+    latency    = CompressorCore::latencySamples(SR);
+
+    params = newParams;
+    params.prepare(SR);
+    core.updateCurve(params);
+
+    detected = 0;
+    filled   = 0;
+    points.clear();
+
+    // levels only, no delay line
+    return core.setup(SR, 0);
+}
+
+//------------------------------------------------------------------------
+void GainAnalyzer::add(DspSample f_env, DspSample f_gain)
+{
+    if (filled == 0)
+    {
+        envMin  = envMax  = f_env;
+        gainMin = gainMax = f_gain;
+    }
+    else
+    {
+        if( f_env < envMin ) envMin = f_env;
+        if( f_env > envMax ) envMax = f_env;
+        if( f_gain < gainMin ) gainMin = f_gain;
+        if( f_gain > gainMax ) gainMax = f_gain;
+    }
+    detected++;
+
+    if (++filled * step == window)
+        flush();
+}
+
+//------------------------------------------------------------------------
+void GainAnalyzer::flush()
+{
+    if (filled == 0)
+        return;
+
+    // window start in output samples, minus the lookahead gives input time
+    const uint64_t start = (detected - filled) * step;
+    const uint64_t end   = detected * step;
+    filled = 0;
+
+    // still inside the lookahead, nothing of the input reached the detector
+    if (end <= latency)
+        return;
+
+    AnalysisPoint p;
+    p.time     = (start > latency) ? double(start - latency) / sampleRate : 0.0;
+    p.envMinDb = static_cast<float>(gainToDecibels(envMin));
+    p.envMaxDb = static_cast<float>(gainToDecibels(envMax));
+    p.grMinDb  = static_cast<float>(gainToDecibels(gainMin));
+    p.grMaxDb  = static_cast<float>(gainToDecibels(gainMax));
+    points.push_back(p);
+}
+
+//------------------------------------------------------------------------
+void GainAnalyzer::finish()
+{
+    // run the last lookahead worth of input through with silence behind it
+    DspSample  silence[64] = {};
+    DspSample* inputs[1]   = {silence};
+    for (uint32 left = latency; left > 0;)
+    {
+        const int32 n = static_cast<int32>(std::min<uint32>(left, 64));
+        process(inputs, 1, n);
+        left -= n;
+    }
+    flush();
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_core.h"
+#include "VLCComp_denormal.h"
+
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  AnalysisPoint
+//  Detector level and gain reduction over one decimation window, min/max,
+//  in dB. time is the window start in seconds of input time, i.e. with
+//  the lookahead latency already taken out.
+//------------------------------------------------------------------------
+struct AnalysisPoint
+{
+    double time     = 0.0;
+    float  envMinDb = -100.f, envMaxDb = -100.f;
+    float  grMinDb  = 0.f,    grMaxDb  = 0.f;
+};
+
+//------------------------------------------------------------------------
+//  GainAnalyzer
+//  Offline detector-only pass: feeds audio through CompressorCore::analyze
+//  and collects one AnalysisPoint per window. No delay line, gain stage or
+//  metering runs, so it goes as fast as the detector alone.
+//------------------------------------------------------------------------
+class GainAnalyzer
+{
+public:
+    using SampleRate = Steinberg::Vst::SampleRate;
+
+    /** params are prepared here. windowSamples is rounded up to a multiple
+     *  of 4 detector frames, the rate the gain computer runs at. */
+    bool setup(SampleRate SR, const CompParams& params, uint32 windowSamples);
+
+    template <typename SampleType>
+    void process(SampleType** inputs, int32 numChannels, int32 sampleFrames)
+    {
+        Collector     collector {*this};
+        DenormalGuard denormalGuard;   // per block, the envelopes decay in silence
+        core.analyze(inputs, numChannels, sampleFrames, params, collector);
+    }
+
+    /** Flushes a partly filled last window. */
+    void finish();
+
+    const std::vector<AnalysisPoint>& getPoints() const { return points; }
+    void clearPoints() { points.clear(); } // after consuming them, for streaming use
+
+    uint32 getWindowSamples() const { return window; }
+
+private:
+    struct Collector
+    {
+        GainAnalyzer& a;
+        void detector(DspSample f_env, DspSample f_gain) { a.add(f_env, f_gain); }
+    };
+
+    void add(DspSample f_env, DspSample f_gain);
+    void flush();
+
+    CompressorCore core;
+    CompParams     params;
+    SampleRate     sampleRate = 48000.0;
+    uint32         window     = 480;
+    uint32         latency    = 0;
+    uint32         step       = 4;  // samples per gain computer step
+
+    uint64_t  detected = 0;     // gain computer steps so far, each is step samples
+    uint32    filled   = 0;     // steps in the current window
+    DspSample envMin = 0.0, envMax = 0.0;
+    DspSample gainMin = 1.0, gainMax = 1.0;
+
+    std::vector<AnalysisPoint> points;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
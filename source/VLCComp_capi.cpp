@@ -0,0 +1,336 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_capi.h"
+#include "VLCComp_core.h"
+#include "VLCComp_curvecache.h"
+#include "VLCComp_denormal.h"
+
+#include <algorithm>
+#include <exception>
+
+using namespace yg331;
+
+//------------------------------------------------------------------------
+//  vlccomp
+//  A CompressorCore with its parameters in plain units, the way the C side
+//  set them, and the meters since they were last read.
+//------------------------------------------------------------------------
+struct vlccomp
+{
+    CompressorCore core;
+    CompParams     params;
+    CurveFeed          curves;          // tables for set_param changes, built off process()
+    CurveCache::Handle preparedCurve;   // params at prepare
+    double         values[VLCCOMP_PARAM_COUNT];
+    double         sampleRate  = 0.0;
+    int32          numChannels = 0;
+    bool           dirty       = true;      // params to prepare before the next block
+
+    double    peakIn  = 0.0;
+    double    peakOut = 0.0;
+    DspSample minGain = 1.0;
+};
+
+namespace {
+//------------------------------------------------------------------------
+//  Strided views for CompressorCore::process(): sample (c, i) at
+//  base[c][i * stride]. Planar buffers with stride 1 skip them and go in
+//  as plain pointers.
+//------------------------------------------------------------------------
+template <typename T>
+struct StridedChannel
+{
+    T*        p;
+    ptrdiff_t stride;
+
+    T& operator[](ptrdiff_t i) const { return p[i * stride]; }
+    StridedChannel operator+(ptrdiff_t frames) const { return {p + frames * stride, stride}; }
+};
+
+template <typename T>
+struct StridedBuffers
+{
+    T*        base[AOUT_CHAN_MAX];
+    ptrdiff_t stride;
+
+    StridedChannel<T> operator[](int32 ch) const { return {base[ch], stride}; }
+
+    StridedBuffers at(size_t frame) const
+    {
+        StridedBuffers b = *this;
+        for (T*& p : b.base)
+            p = p ? p + ptrdiff_t(frame) * stride : nullptr;
+        return b;
+    }
+};
+
+template <typename T>
+StridedBuffers<T> stridedView(const vlccomp_buffer& b, int32 numChannels)
+{
+    StridedBuffers<T> v = {};
+    v.stride = b.frame_stride;
+    for (int32 ch = 0; ch < numChannels; ch++)
+        v.base[ch] = b.channels ? static_cast<T*>(b.channels[ch])
+                                : static_cast<T*>(b.data) + ch * b.channel_stride;
+    return v;
+}
+
+bool isValid(const vlccomp_buffer& b, int32 numChannels)
+{
+    if (b.format != VLCCOMP_FLOAT32 && b.format != VLCCOMP_FLOAT64)
+        return false;
+    if (!b.channels)
+        return b.data != nullptr;
+    for (int32 ch = 0; ch < numChannels; ch++)
+        if (!b.channels[ch])
+            return false;
+    return true;
+}
+
+//------------------------------------------------------------------------
+struct MeterTap
+{
+    vlccomp& comp;
+
+    void detector(DspSample /*f_env*/, DspSample /*f_gain*/) {}
+    void sample(int32 /*ch*/, double in, double out, DspSample f_gain)
+    {
+        comp.peakIn  = std::max(comp.peakIn,  std::abs(in));
+        comp.peakOut = std::max(comp.peakOut, std::abs(out));
+        comp.minGain = std::min(comp.minGain, f_gain);
+    }
+};
+
+// int32 frames per core call
+constexpr size_t kMaxFrames = size_t(1) << 16;
+
+template <typename T>
+void processAs(vlccomp& comp, const vlccomp_buffer& in, const vlccomp_buffer& out, size_t frames)
+{
+    MeterTap    tap {comp};
+    const int32 numChannels = comp.numChannels;
+
+    if (in.channels && out.channels && in.frame_stride == 1 && out.frame_stride == 1)
+    {
+        T* inputs[AOUT_CHAN_MAX];
+        T* outputs[AOUT_CHAN_MAX];
+        for (size_t done = 0; done < frames; done += kMaxFrames)
+        {
+            const int32 count = static_cast<int32>(std::min(kMaxFrames, frames - done));
+            for (int32 ch = 0; ch < numChannels; ch++)
+            {
+                inputs[ch]  = static_cast<T*>(in.channels[ch]) + done;
+                outputs[ch] = static_cast<T*>(out.channels[ch]) + done;
+            }
+            comp.core.process(inputs, outputs, numChannels, count, comp.params, tap);
+        }
+        return;
+    }
+
+    const StridedBuffers<T> inputs  = stridedView<T>(in, numChannels);
+    const StridedBuffers<T> outputs = stridedView<T>(out, numChannels);
+    for (size_t done = 0; done < frames; done += kMaxFrames)
+    {
+        const int32 count = static_cast<int32>(std::min(kMaxFrames, frames - done));
+        comp.core.process(inputs.at(done), outputs.at(done), numChannels, count, comp.params, tap);
+    }
+}
+
+//------------------------------------------------------------------------
+// Plain value into the normalized one CompParams holds, clamped like the
+// editor knobs
+ParamValue clampParam(vlccomp_param param, double v)
+{
+    switch (param)
+    {
+        case VLCCOMP_PARAM_THRESHOLD:   return LIMIT(v, minThreshold, maxThreshold);
+        case VLCCOMP_PARAM_RATIO:       return LIMIT(v, minRatio,     maxRatio);
+        case VLCCOMP_PARAM_KNEE:        return LIMIT(v, minKnee,      maxKnee);
+        case VLCCOMP_PARAM_ATTACK:      return LIMIT(v, minAttack,    maxAttack);
+        case VLCCOMP_PARAM_RELEASE:     return LIMIT(v, minRelease,   maxRelease);
+        case VLCCOMP_PARAM_RMS_PEAK:    return LIMIT(v, minRMS_PEAK,  maxRMS_PEAK);
+        case VLCCOMP_PARAM_INPUT:       return LIMIT(v, minInput,     maxInput);
+        case VLCCOMP_PARAM_OUTPUT:      return LIMIT(v, minOutput,    maxOutput);
+        case VLCCOMP_PARAM_MAKEUP:      return LIMIT(v, minMakeup,    maxMakeup);
+        case VLCCOMP_PARAM_MIX:         return LIMIT(v, minMix,       maxMix);
+        case VLCCOMP_PARAM_SOFT_BYPASS: return v > 0.5 ? 1.0 : 0.0;
+        case VLCCOMP_PARAM_ANTICIPATE:  return v > 0.5 ? 1.0 : 0.0;
+        default:                        return 0.0;
+    }
+}
+
+void setNormalized(CompParams& p, vlccomp_param param, double v)
+{
+    switch (param)
+    {
+        case VLCCOMP_PARAM_THRESHOLD:   p.pThreshold  = Plain2Norm(v, minThreshold, maxThreshold); break;
+        case VLCCOMP_PARAM_RATIO:       p.pRatio      = Plain2Norm(v, minRatio,     maxRatio);     break;
+        case VLCCOMP_PARAM_KNEE:        p.pKnee       = Plain2Norm(v, minKnee,      maxKnee);      break;
+        case VLCCOMP_PARAM_ATTACK:      p.pAttack     = LogPlain2Norm(v, minAttack, maxAttack);    break;
+        case VLCCOMP_PARAM_RELEASE:     p.pRelease    = Plain2Norm(v, minRelease,   maxRelease);   break;
+        case VLCCOMP_PARAM_RMS_PEAK:    p.pRMS_PEAK   = Plain2Norm(v, minRMS_PEAK,  maxRMS_PEAK);  break;
+        case VLCCOMP_PARAM_INPUT:       p.pInput      = Plain2Norm(v, minInput,     maxInput);     break;
+        case VLCCOMP_PARAM_OUTPUT:      p.pOutput     = Plain2Norm(v, minOutput,    maxOutput);    break;
+        case VLCCOMP_PARAM_MAKEUP:      p.pMakeup     = Plain2Norm(v, minMakeup,    maxMakeup);    break;
+        case VLCCOMP_PARAM_MIX:         p.pMix        = Plain2Norm(v, minMix,       maxMix);       break;
+        case VLCCOMP_PARAM_SOFT_BYPASS: p.pSoftBypass = v > 0.5;                                   break;
+        case VLCCOMP_PARAM_ANTICIPATE:  p.pAnticipate = v > 0.5;                                   break;
+        default: break;
+    }
+}
+} // namespace
+
+//------------------------------------------------------------------------
+// C API
+//------------------------------------------------------------------------
+extern "C" {
+
+uint32_t vlccomp_api_version(void)
+{
+    return VLCCOMP_API_VERSION;
+}
+
+vlccomp* vlccomp_create(uint32_t api_version)
+{
+    if (api_version != VLCCOMP_API_VERSION)
+        return nullptr;
+
+    vlccomp* comp = nullptr;
+    try
+    {
+        comp = new vlccomp;   // and the curve builder thread with the first one
+    }
+    catch (const std::exception&)
+    {
+        return nullptr;
+    }
+
+    const double defaults[VLCCOMP_PARAM_COUNT] = {
+        dftThreshold, dftRatio, dftKnee, dftAttack, dftRelease, dftRMS_PEAK,
+        dftInput, dftOutput, dftMakeup, dftMix, 0.0, 0.0
+    };
+    std::copy(defaults, defaults + VLCCOMP_PARAM_COUNT, comp->values);
+    return comp;
+}
+
+void vlccomp_destroy(vlccomp* comp)
+{
+    delete comp;
+}
+
+vlccomp_status vlccomp_prepare(vlccomp* comp, double sample_rate, int num_channels)
+{
+    if (!comp || !(sample_rate > 0.0) || num_channels < 1 || num_channels > AOUT_CHAN_MAX)
+        return VLCCOMP_ERROR_ARGUMENT;
+
+    if (!comp->core.setup(sample_rate, num_channels))
+    {
+        comp->sampleRate  = 0.0;
+        comp->numChannels = 0;
+        return VLCCOMP_ERROR_MEMORY;
+    }
+    comp->sampleRate  = sample_rate;
+    comp->numChannels = num_channels;
+    comp->params.prepare(sample_rate);
+    try
+    {
+        comp->preparedCurve = CurveCache::acquire(comp->params.f_threshold, comp->params.f_knee, comp->params.f_rs);
+    }
+    catch (const std::exception&)
+    {
+        return VLCCOMP_ERROR_MEMORY;
+    }
+    comp->curves.fetch();   // older than this
+    comp->core.setCurve(comp->preparedCurve.get());
+    comp->dirty = false;
+    return vlccomp_reset(comp);
+}
+
+vlccomp_status vlccomp_reset(vlccomp* comp)
+{
+    if (!comp)
+        return VLCCOMP_ERROR_ARGUMENT;
+    if (!comp->core.isReady())
+        return VLCCOMP_ERROR_STATE;
+
+    comp->core.reset();
+    comp->peakIn  = 0.0;
+    comp->peakOut = 0.0;
+    comp->minGain = 1.0;
+    return VLCCOMP_OK;
+}
+
+vlccomp_status vlccomp_set_param(vlccomp* comp, vlccomp_param param, double value)
+{
+    if (!comp || param < 0 || param >= VLCCOMP_PARAM_COUNT || value != value)
+        return VLCCOMP_ERROR_ARGUMENT;
+
+    comp->values[param] = clampParam(param, value);
+    setNormalized(comp->params, param, comp->values[param]);
+    comp->dirty = true;
+    return VLCCOMP_OK;
+}
+
+vlccomp_status vlccomp_get_param(const vlccomp* comp, vlccomp_param param, double* value)
+{
+    if (!comp || !value || param < 0 || param >= VLCCOMP_PARAM_COUNT)
+        return VLCCOMP_ERROR_ARGUMENT;
+
+    *value = comp->values[param];
+    return VLCCOMP_OK;
+}
+
+uint32_t vlccomp_latency(const vlccomp* comp)
+{
+    return (comp && comp->core.isReady()) ? CompressorCore::latencySamples(comp->sampleRate) : 0;
+}
+
+vlccomp_status vlccomp_process(vlccomp* comp, const vlccomp_buffer* in, const vlccomp_buffer* out, size_t frames)
+{
+    if (!comp || !in || !out)
+        return VLCCOMP_ERROR_ARGUMENT;
+    if (!comp->core.isReady())
+        return VLCCOMP_ERROR_STATE;
+    if (in->format != out->format || !isValid(*in, comp->numChannels) || !isValid(*out, comp->numChannels))
+        return VLCCOMP_ERROR_ARGUMENT;
+
+    // a changed curve is evaluated exactly until the builder thread
+    // brings its table, as in the plugin
+    if (comp->dirty)
+    {
+        comp->params.prepare(comp->sampleRate);
+        comp->dirty = false;
+    }
+    if (comp->curves.fetch())
+        comp->core.setCurve(comp->curves.front());
+    if (!comp->core.curveReady(comp->params))
+        comp->curves.want(comp->params.f_threshold, comp->params.f_knee, comp->params.f_rs);
+
+    DenormalGuard denormalGuard;
+    if (in->format == VLCCOMP_FLOAT32)
+        processAs<float>(*comp, *in, *out, frames);
+    else
+        processAs<double>(*comp, *in, *out, frames);
+    return VLCCOMP_OK;
+}
+
+vlccomp_status vlccomp_get_meters(vlccomp* comp, vlccomp_meters* meters)
+{
+    if (!comp || !meters)
+        return VLCCOMP_ERROR_ARGUMENT;
+
+    meters->input_peak     = gainToDecibels(comp->peakIn);
+    meters->output_peak    = gainToDecibels(comp->peakOut);
+    meters->gain_reduction = gainToDecibels(static_cast<double>(comp->minGain));
+    meters->envelope       = gainToDecibels(static_cast<double>(comp->core.getEnvelope()));
+    meters->gain           = gainToDecibels(static_cast<double>(comp->core.getGain()));
+
+    comp->peakIn  = 0.0;
+    comp->peakOut = 0.0;
+    comp->minGain = 1.0;
+    return VLCCOMP_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,158 @@
+/*------------------------------------------------------------------------
+ * Copyright(c) 2024 yg331.
+ *------------------------------------------------------------------------
+ *  VLC Compressor C API
+ *  The compressor core behind a plain C interface, for embedding without
+ *  hosting a plugin (libvlccomp, VLCCOMP_LIBRARY build option). Same
+ *  detector, gain computer and 10 ms lookahead as the VST3, output
+ *  matches it bit for bit.
+ *
+ *  An instance is not thread safe, separate instances are independent.
+ *  process() neither allocates nor locks; create, prepare and destroy do.
+ *  The gain curve's tables are built on a background thread, which the
+ *  first instance starts and the last one destroyed stops: after a
+ *  threshold, knee or ratio change process() evaluates the curve exactly
+ *  for the few milliseconds until its table is in.
+ *
+ *  Audio is read and written where the caller keeps it, no copies: a
+ *  vlccomp_buffer describes planar, interleaved or any strided layout of
+ *  float or double samples, see the vlccomp_*_buffer() helpers.
+ *
+ *  Versioning: VLCCOMP_API_VERSION is bumped on every change that breaks
+ *  callers built against an older header; vlccomp_create() refuses other
+ *  versions. Additions keep the version and only ever append.
+ *------------------------------------------------------------------------*/
+
+#ifndef VLCCOMP_CAPI_H
+#define VLCCOMP_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(VLCCOMP_BUILDING_LIBRARY)
+#    define VLCCOMP_API __declspec(dllexport)
+#  else
+#    define VLCCOMP_API __declspec(dllimport)
+#  endif
+#else
+#  define VLCCOMP_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VLCCOMP_API_VERSION 1
+
+typedef struct vlccomp vlccomp;
+
+typedef enum vlccomp_status
+{
+    VLCCOMP_OK             =  0,
+    VLCCOMP_ERROR_ARGUMENT = -1,  /* null pointer, out of range, bad layout */
+    VLCCOMP_ERROR_MEMORY   = -2,
+    VLCCOMP_ERROR_STATE    = -3,  /* process() before prepare() */
+    VLCCOMP_ERROR_VERSION  = -4
+} vlccomp_status;
+
+/* Parameters in plain units, clamped to the plugin's ranges */
+typedef enum vlccomp_param
+{
+    VLCCOMP_PARAM_THRESHOLD   = 0,  /* dB */
+    VLCCOMP_PARAM_RATIO       = 1,  /* n:1 */
+    VLCCOMP_PARAM_KNEE        = 2,  /* dB */
+    VLCCOMP_PARAM_ATTACK      = 3,  /* ms */
+    VLCCOMP_PARAM_RELEASE     = 4,  /* ms */
+    VLCCOMP_PARAM_RMS_PEAK    = 5,  /* %, 0 RMS .. 100 peak detection */
+    VLCCOMP_PARAM_INPUT       = 6,  /* dB */
+    VLCCOMP_PARAM_OUTPUT      = 7,  /* dB */
+    VLCCOMP_PARAM_MAKEUP      = 8,  /* dB */
+    VLCCOMP_PARAM_MIX         = 9,  /* %, dry .. wet */
+    VLCCOMP_PARAM_SOFT_BYPASS = 10, /* 0 or 1, delayed dry signal */
+    VLCCOMP_PARAM_ANTICIPATE  = 11, /* 0 or 1, peak detection across the lookahead */
+    VLCCOMP_PARAM_COUNT
+} vlccomp_param;
+
+typedef enum vlccomp_format
+{
+    VLCCOMP_FLOAT32 = 0,
+    VLCCOMP_FLOAT64 = 1
+} vlccomp_format;
+
+/* Sample (c, i), channel c and frame i, is at
+ *   channels ? channels[c] + i * frame_stride
+ *            : data + c * channel_stride + i * frame_stride
+ * strides counted in samples, not bytes. */
+typedef struct vlccomp_buffer
+{
+    vlccomp_format format;
+    void* const*   channels;        /* one pointer per channel, or NULL */
+    void*          data;            /* used when channels is NULL */
+    ptrdiff_t      channel_stride;
+    ptrdiff_t      frame_stride;
+} vlccomp_buffer;
+
+/* Readings since the previous vlccomp_get_meters() call, in dB */
+typedef struct vlccomp_meters
+{
+    double input_peak;
+    double output_peak;
+    double gain_reduction;      /* deepest, <= 0 */
+    double envelope;            /* detector level now */
+    double gain;                /* smoothed gain now, <= 0 before makeup */
+} vlccomp_meters;
+
+static inline vlccomp_buffer vlccomp_planar_buffer(vlccomp_format format, void* const* channels)
+{
+    vlccomp_buffer b = { format, channels, NULL, 0, 1 };
+    return b;
+}
+
+static inline vlccomp_buffer vlccomp_interleaved_buffer(vlccomp_format format, void* data, int num_channels)
+{
+    vlccomp_buffer b = { format, NULL, data, 1, num_channels };
+    return b;
+}
+
+static inline vlccomp_buffer vlccomp_strided_buffer(vlccomp_format format, void* data,
+                                                    ptrdiff_t channel_stride, ptrdiff_t frame_stride)
+{
+    vlccomp_buffer b = { format, NULL, data, channel_stride, frame_stride };
+    return b;
+}
+
+/* VLCCOMP_API_VERSION the library was built with */
+VLCCOMP_API uint32_t vlccomp_api_version(void);
+
+/* Pass VLCCOMP_API_VERSION; NULL if the library doesn't speak it or
+ * memory ran out. Parameters start at the plugin's defaults. */
+VLCCOMP_API vlccomp* vlccomp_create(uint32_t api_version);
+VLCCOMP_API void     vlccomp_destroy(vlccomp* comp);
+
+/* Sizes the delay line for this rate and up to 9 channels and clears it.
+ * Allocates; call again to change either. */
+VLCCOMP_API vlccomp_status vlccomp_prepare(vlccomp* comp, double sample_rate, int num_channels);
+
+/* Back to silence, keeps rate, channels and parameters */
+VLCCOMP_API vlccomp_status vlccomp_reset(vlccomp* comp);
+
+/* Takes effect from the next vlccomp_process() on */
+VLCCOMP_API vlccomp_status vlccomp_set_param(vlccomp* comp, vlccomp_param param, double value);
+VLCCOMP_API vlccomp_status vlccomp_get_param(const vlccomp* comp, vlccomp_param param, double* value);
+
+/* Output lags input by this many frames, 10 ms */
+VLCCOMP_API uint32_t vlccomp_latency(const vlccomp* comp);
+
+/* Compresses frames of num_channels (as prepared) from in to out, both in
+ * the same format, each in its own layout. They may be the same memory. */
+VLCCOMP_API vlccomp_status vlccomp_process(vlccomp* comp, const vlccomp_buffer* in,
+                                           const vlccomp_buffer* out, size_t frames);
+
+VLCCOMP_API vlccomp_status vlccomp_get_meters(vlccomp* comp, vlccomp_meters* meters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VLCCOMP_CAPI_H */
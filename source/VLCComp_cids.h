@@ -28,7 +28,14 @@ enum {
     kParamKnee,
     kParamMakeup,
     kParamMix,
-    kParamSoftBypass
+    kParamSoftBypass,
+    kParamAnticipate,
+    kNumParams
+};
+
+// Program list of the root unit, also the ID of its program-change parameter
+enum {
+    kParamProgram = 1000
 };
 //------------------------------------------------------------------------
 } // namespace yg331
@@ -0,0 +1,698 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+//  VLC Compressor CLAP plug-in (VLCCOMP_CLAP build option)
+//  The compressor core as a CLAP: same detector, gain computer, 10 ms
+//  lookahead and state chunk as the VST3, so sessions move between the two.
+//  No editor and no program list, the host shows the parameters.
+//
+//  Parameter events come in one list sorted by time; the core runs from
+//  one event time to the next, so automation is sample accurate. Audio is
+//  processed in place when the host hands the same buffers in and out.
+//  An offline render (clap.render) gets the core's offline quality.
+//------------------------------------------------------------------------
+
+#include "VLCComp_core.h"
+#include "VLCComp_curvecache.h"
+#include "VLCComp_denormal.h"
+#include "VLCComp_rtcheck.h"
+#include "VLCComp_state.h"
+
+#include <clap/clap.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace Steinberg;
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+//  Parameters in plain units, the VST3 IDs, minus the editor zoom and the
+//  oversampling choice. Both still go through the state untouched.
+//------------------------------------------------------------------------
+struct ClapParam
+{
+    clap_id     id;
+    const char* name;
+    const char* unit;
+    double      min, max, def;
+    bool        log;        // attack: normalized on a log scale
+    bool        stepped;    // off/on
+};
+
+const ClapParam kClapParams[] = {
+    { kParamBypass,     "Bypass",     "",   0.0,          1.0,          0.0,          false, true  },
+    { kParamInput,      "Input",      "dB", minInput,     maxInput,     dftInput,     false, false },
+    { kParamOutput,     "Output",     "dB", minOutput,    maxOutput,    dftOutput,    false, false },
+    { kParamRMS_PEAK,   "RMS/PEAK",   "%",  minRMS_PEAK,  maxRMS_PEAK,  dftRMS_PEAK,  false, false },
+    { kParamAttack,     "Attack",     "ms", minAttack,    maxAttack,    dftAttack,    true,  false },
+    { kParamRelease,    "Release",    "ms", minRelease,   maxRelease,   dftRelease,   false, false },
+    { kParamThreshold,  "Threshold",  "dB", minThreshold, maxThreshold, dftThreshold, false, false },
+    { kParamRatio,      "Ratio",      "",   minRatio,     maxRatio,     dftRatio,     false, false },
+    { kParamKnee,       "Knee",       "dB", minKnee,      maxKnee,      dftKnee,      false, false },
+    { kParamMakeup,     "Makeup",     "dB", minMakeup,    maxMakeup,    dftMakeup,    false, false },
+    { kParamMix,        "Mix",        "%",  minMix,       maxMix,       dftMix,       false, false },
+    { kParamSoftBypass, "SoftBypass", "",   0.0,          1.0,          0.0,          false, true  },
+    { kParamAnticipate, "Anticipate", "",   0.0,          1.0,          0.0,          false, true  },
+};
+constexpr uint32 kNumClapParams = sizeof(kClapParams) / sizeof(kClapParams[0]);
+
+const ClapParam* findParam(clap_id id)
+{
+    for (const ClapParam& p : kClapParams)
+        if (p.id == id)
+            return &p;
+    return nullptr;
+}
+
+ParamValue toNormalized(const ClapParam& p, double plain)
+{
+    plain = LIMIT(plain, p.min, p.max);
+    if (p.stepped)
+        return plain > 0.5 ? 1.0 : 0.0;
+    return p.log ? LogPlain2Norm(plain, p.min, p.max) : Plain2Norm(plain, p.min, p.max);
+}
+
+double toPlain(const ClapParam& p, ParamValue normalized)
+{
+    if (p.stepped)
+        return normalized > 0.5 ? 1.0 : 0.0;
+    return p.log ? LogNorm2Plain(normalized, p.min, p.max) : Norm2Plain(normalized, p.min, p.max);
+}
+
+// Returns whether the value differs from the one held, hosts resend them
+bool setNormalized(CompParams& p, clap_id id, ParamValue value)
+{
+    bool changed = false;
+#define setParam(dst, val) { auto _v = (val); if (dst != _v) { dst = _v; changed = true; } }
+    switch (id) {
+        case kParamBypass:     setParam(p.pBypass,     (value > 0.5)); break;
+        case kParamInput:      setParam(p.pInput,      value); break;
+        case kParamOutput:     setParam(p.pOutput,     value); break;
+        case kParamRMS_PEAK:   setParam(p.pRMS_PEAK,   value); break;
+        case kParamAttack:     setParam(p.pAttack,     value); break;
+        case kParamRelease:    setParam(p.pRelease,    value); break;
+        case kParamThreshold:  setParam(p.pThreshold,  value); break;
+        case kParamRatio:      setParam(p.pRatio,      value); break;
+        case kParamKnee:       setParam(p.pKnee,       value); break;
+        case kParamMakeup:     setParam(p.pMakeup,     value); break;
+        case kParamMix:        setParam(p.pMix,        value); break;
+        case kParamSoftBypass: setParam(p.pSoftBypass, (value > 0.5)); break;
+        case kParamAnticipate: setParam(p.pAnticipate, (value > 0.5)); break;
+        default: break;
+    }
+#undef setParam
+    return changed;
+}
+
+// Parameter value events, everything else is none of ours
+bool applyEvent(CompParams& p, const clap_event_header_t* header)
+{
+    if (header->space_id != CLAP_CORE_EVENT_SPACE_ID || header->type != CLAP_EVENT_PARAM_VALUE)
+        return false;
+
+    const auto* event = reinterpret_cast<const clap_event_param_value_t*>(header);
+    const ClapParam* param = findParam(event->param_id);
+    if (!param || !(event->value == event->value))
+        return false;
+    return setNormalized(p, param->id, toNormalized(*param, event->value));
+}
+
+//------------------------------------------------------------------------
+//  ClapStream
+//  A CLAP state stream seen as an IBStream, so readState/writeState and
+//  with them the chunk format are the VST3's own. CLAP streams may move
+//  fewer bytes than asked, both directions loop until done or stuck.
+//------------------------------------------------------------------------
+class ClapStream : public IBStream
+{
+public:
+    explicit ClapStream(const clap_istream_t* in)  : in(in) { FUNKNOWN_CTOR }
+    explicit ClapStream(const clap_ostream_t* out) : out(out) { FUNKNOWN_CTOR }
+    virtual ~ClapStream() { FUNKNOWN_DTOR }
+
+    tresult PLUGIN_API read(void* buffer, int32 numBytes, int32* numBytesRead) SMTG_OVERRIDE
+    {
+        int32 done = 0;
+        while (in && done < numBytes)
+        {
+            const int64_t n = in->read(in, static_cast<char*>(buffer) + done, static_cast<uint64_t>(numBytes - done));
+            if (n <= 0)
+                break;
+            done += static_cast<int32>(n);
+        }
+        if (numBytesRead)
+            *numBytesRead = done;
+        return (in && done == numBytes) ? kResultTrue : kResultFalse;
+    }
+
+    tresult PLUGIN_API write(void* buffer, int32 numBytes, int32* numBytesWritten) SMTG_OVERRIDE
+    {
+        int32 done = 0;
+        while (out && done < numBytes)
+        {
+            const int64_t n = out->write(out, static_cast<const char*>(buffer) + done, static_cast<uint64_t>(numBytes - done));
+            if (n <= 0)
+                break;
+            done += static_cast<int32>(n);
+        }
+        if (numBytesWritten)
+            *numBytesWritten = done;
+        return (out && done == numBytes) ? kResultTrue : kResultFalse;
+    }
+
+    // CLAP streams only go forward
+    tresult PLUGIN_API seek(int64 /*pos*/, int32 /*mode*/, int64* /*result*/) SMTG_OVERRIDE { return kNotImplemented; }
+    tresult PLUGIN_API tell(int64* /*pos*/) SMTG_OVERRIDE { return kNotImplemented; }
+
+    DECLARE_FUNKNOWN_METHODS
+
+private:
+    const clap_istream_t* in  = nullptr;
+    const clap_ostream_t* out = nullptr;
+};
+IMPLEMENT_FUNKNOWN_METHODS(ClapStream, IBStream, IBStream::iid)
+
+//------------------------------------------------------------------------
+const char* const kFeatures[] = {
+    CLAP_PLUGIN_FEATURE_AUDIO_EFFECT,
+    CLAP_PLUGIN_FEATURE_COMPRESSOR,
+    CLAP_PLUGIN_FEATURE_STEREO,
+    nullptr
+};
+
+const clap_plugin_descriptor_t kDescriptor = {
+    CLAP_VERSION_INIT,
+    "io.github.yg331.vlc-compressor",
+    "VLC Compressor",
+    "yg331",
+    "https://github.com/Kiriki-liszt/VLC_Compressor",
+    "",
+    "",
+    VLCCOMP_VERSION_STR,
+    "Dynamic range compressor ported from VLC, with 10 ms lookahead",
+    kFeatures
+};
+
+//------------------------------------------------------------------------
+//  VLC_CompClap
+//  Threads as in VLC_CompProcessor: the main thread keeps hostParams and
+//  hands loaded states over in triple buffers, the audio thread owns
+//  params and the core and hands automated sets back.
+//------------------------------------------------------------------------
+class VLC_CompClap
+{
+public:
+    explicit VLC_CompClap(const clap_host_t* host);
+
+    const clap_plugin_t* clapPlugin() const { return &plugin; }
+
+private:
+    static VLC_CompClap* self(const clap_plugin_t* p) { return static_cast<VLC_CompClap*>(p->plugin_data); }
+
+    // clap_plugin
+    bool init();
+    bool activate(double sampleRate);
+    void deactivate() { active = false; }
+    void reset() { if (core.isReady()) core.reset(); }
+    clap_process_status process(const clap_process_t* process);
+    const void* getExtension(const char* id) const;
+
+    // clap.params
+    bool getValue(clap_id id, double* value);
+    static bool valueToText(clap_id id, double value, char* text, uint32_t capacity);
+    static bool textToValue(clap_id id, const char* text, double* value);
+    void flush(const clap_input_events_t* in);
+
+    // clap.state
+    bool load(const clap_istream_t* stream);
+    bool save(const clap_ostream_t* stream);
+
+    // clap.render: the core's quality follows, from the next activate()
+    bool setRenderMode(clap_plugin_render_mode mode);
+
+    /** Runs task(0) ... task(count - 1) on the host's worker threads, or
+     *  here, one after the other, when the host has no pool or declines.
+     *  Returns when all are done. Audio thread, inside process() only. */
+    template <typename Task>
+    void runTasks(uint32_t count, Task& task)
+    {
+        poolTask    = [](void* context, uint32_t index) { (*static_cast<Task*>(context))(index); };
+        poolContext = &task;
+        if (!hostThreadPool || !hostThreadPool->request_exec(host, count))
+        {
+            for (uint32_t index = 0; index < count; index++)
+                task(index);
+        }
+        poolTask    = nullptr;
+        poolContext = nullptr;
+    }
+
+    void syncFromAudio();   // main thread
+
+    template <typename SampleType>
+    void processRange(SampleType** inputs, SampleType** outputs, int32 numChannels, uint32_t first, uint32_t count);
+
+    clap_plugin_t      plugin;
+    const clap_host_t* host;
+    const clap_host_thread_pool_t* hostThreadPool = nullptr;
+
+    // Main thread and cross-thread side -----------------------------------
+    double     SR     = 48000.0;
+    bool       active = false;
+    CompressorCore::Quality quality = CompressorCore::kRealtime;   // clap.render
+    CompParams hostParams;
+    TripleBuffer<CompParams> paramsToAudio;     // load -> process
+    TripleBuffer<CompParams> paramsFromAudio;   // process -> save, get_value
+    CurveFeed          curvesToAudio;       // load, builder -> process
+    CurveCache::Handle activeCurve;         // params at activate
+
+    // Audio thread --------------------------------------------------------
+    alignas(64) CompParams params;
+    CompressorCore core;
+    void (*poolTask)(void*, uint32_t) = nullptr;    // runTasks() in flight
+    void* poolContext                 = nullptr;
+};
+
+//------------------------------------------------------------------------
+VLC_CompClap::VLC_CompClap(const clap_host_t* host)
+    : host(host)
+{
+    plugin.desc        = &kDescriptor;
+    plugin.plugin_data = this;
+    plugin.init        = [](const clap_plugin_t* p) { return self(p)->init(); };
+    plugin.destroy     = [](const clap_plugin_t* p) { delete self(p); };
+    plugin.activate    = [](const clap_plugin_t* p, double sampleRate, uint32_t /*minFrames*/, uint32_t /*maxFrames*/) {
+        return self(p)->activate(sampleRate);
+    };
+    plugin.deactivate       = [](const clap_plugin_t* p) { self(p)->deactivate(); };
+    plugin.start_processing = [](const clap_plugin_t* /*p*/) { return true; };
+    plugin.stop_processing  = [](const clap_plugin_t* /*p*/) {};
+    plugin.reset            = [](const clap_plugin_t* p) { self(p)->reset(); };
+    plugin.process          = [](const clap_plugin_t* p, const clap_process_t* process) { return self(p)->process(process); };
+    plugin.get_extension    = [](const clap_plugin_t* p, const char* id) { return self(p)->getExtension(id); };
+    plugin.on_main_thread   = [](const clap_plugin_t* /*p*/) {};
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::init()
+{
+    hostThreadPool = static_cast<const clap_host_thread_pool_t*>(host->get_extension(host, CLAP_EXT_THREAD_POOL));
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::activate(double sampleRate)
+{
+    SR = sampleRate;
+
+    /* Size the delay line and RMS window to exactly this setup, cleared */
+    if (!core.setup(SR, 2, quality))
+        return false;
+
+    // not processing here, so the audio side copy can be touched directly;
+    // hostParams is the newest set, whatever is still queued is older
+    syncFromAudio();
+    paramsToAudio.fetch();
+    curvesToAudio.fetch();
+
+    hostParams.prepare(SR);
+    params = hostParams;
+    activeCurve = CurveCache::acquire(params.f_threshold, params.f_knee, params.f_rs);
+    core.setCurve(activeCurve.get());
+
+    active = true;
+    return true;
+}
+
+//------------------------------------------------------------------------
+const void* VLC_CompClap::getExtension(const char* id) const
+{
+    static const clap_plugin_params_t params = {
+        [](const clap_plugin_t* /*p*/) { return kNumClapParams; },
+        [](const clap_plugin_t* /*p*/, uint32_t index, clap_param_info_t* info) {
+            if (index >= kNumClapParams)
+                return false;
+            const ClapParam& param = kClapParams[index];
+            std::memset(info, 0, sizeof(*info));
+            info->id    = param.id;
+            info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+            if (param.stepped)
+                info->flags |= CLAP_PARAM_IS_STEPPED;
+            if (param.id == kParamBypass)
+                info->flags |= CLAP_PARAM_IS_BYPASS;
+            std::snprintf(info->name, sizeof(info->name), "%s", param.name);
+            info->min_value     = param.min;
+            info->max_value     = param.max;
+            info->default_value = param.def;
+            return true;
+        },
+        [](const clap_plugin_t* p, clap_id id, double* value) { return self(p)->getValue(id, value); },
+        [](const clap_plugin_t* /*p*/, clap_id id, double value, char* text, uint32_t capacity) {
+            return valueToText(id, value, text, capacity);
+        },
+        [](const clap_plugin_t* /*p*/, clap_id id, const char* text, double* value) {
+            return textToValue(id, text, value);
+        },
+        [](const clap_plugin_t* p, const clap_input_events_t* in, const clap_output_events_t* /*out*/) {
+            self(p)->flush(in);
+        },
+    };
+    static const clap_plugin_audio_ports_t audioPorts = {
+        [](const clap_plugin_t* /*p*/, bool /*isInput*/) { return 1u; },
+        [](const clap_plugin_t* /*p*/, uint32_t index, bool isInput, clap_audio_port_info_t* info) {
+            if (index != 0)
+                return false;
+            info->id = 0;
+            std::snprintf(info->name, sizeof(info->name), "%s", isInput ? "Stereo In" : "Stereo Out");
+            info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS
+                        | CLAP_AUDIO_PORT_REQUIRES_COMMON_SAMPLE_SIZE;
+            info->channel_count = 2;
+            info->port_type     = CLAP_PORT_STEREO;
+            info->in_place_pair = 0;
+            return true;
+        },
+    };
+    static const clap_plugin_latency_t latency = {
+        [](const clap_plugin_t* p) { return CompressorCore::latencySamples(self(p)->SR); },
+    };
+    static const clap_plugin_state_t state = {
+        [](const clap_plugin_t* p, const clap_ostream_t* stream) { return self(p)->save(stream); },
+        [](const clap_plugin_t* p, const clap_istream_t* stream) { return self(p)->load(stream); },
+    };
+    static const clap_plugin_render_t render = {
+        [](const clap_plugin_t* /*p*/) { return false; },
+        [](const clap_plugin_t* p, clap_plugin_render_mode mode) { return self(p)->setRenderMode(mode); },
+    };
+    static const clap_plugin_thread_pool_t threadPool = {
+        [](const clap_plugin_t* p, uint32_t index) {
+            VLC_CompClap* c = self(p);
+            if (c->poolTask)
+                c->poolTask(c->poolContext, index);
+        },
+    };
+
+    if (!std::strcmp(id, CLAP_EXT_PARAMS))      return &params;
+    if (!std::strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &audioPorts;
+    if (!std::strcmp(id, CLAP_EXT_LATENCY))     return &latency;
+    if (!std::strcmp(id, CLAP_EXT_STATE))       return &state;
+    if (!std::strcmp(id, CLAP_EXT_THREAD_POOL)) return &threadPool;
+    if (!std::strcmp(id, CLAP_EXT_RENDER))      return &render;
+    return nullptr;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::setRenderMode(clap_plugin_render_mode mode)
+{
+    const CompressorCore::Quality newQuality =
+        mode == CLAP_RENDER_OFFLINE ? CompressorCore::kOffline : CompressorCore::kRealtime;
+    if (newQuality == quality)
+        return true;
+    quality = newQuality;
+
+    // the core is laid out for the old one while active: same latency, so
+    // only a restart, which re-runs activate(), is needed to switch
+    if (active)
+        host->request_restart(host);
+    return true;
+}
+
+//------------------------------------------------------------------------
+clap_process_status VLC_CompClap::process(const clap_process_t* process)
+{
+    RT_AUDIO_SCOPE();
+    DenormalGuard denormalGuard;
+
+    // Pick up a state loaded since the last block
+    if (paramsToAudio.fetch())
+    {
+        params = paramsToAudio.front();
+        params.prepare(SR);
+    }
+    if (curvesToAudio.fetch())
+        core.setCurve(curvesToAudio.front());
+
+    const clap_input_events_t* events = process->in_events;
+    const uint32_t numEvents = events ? events->size(events) : 0;
+    const uint32_t numFrames = process->frames_count;
+
+    int32 numChannels = 0;
+    const clap_audio_buffer_t* in  = nullptr;
+    const clap_audio_buffer_t* out = nullptr;
+    if (process->audio_inputs_count > 0 && process->audio_outputs_count > 0)
+    {
+        in  = &process->audio_inputs[0];
+        out = &process->audio_outputs[0];
+        numChannels = static_cast<int32>(std::min(in->channel_count, out->channel_count));
+        numChannels = std::min(numChannels, core.isReady() ? core.getChannels() : AOUT_CHAN_MAX);
+    }
+    const bool is64 = in && in->data64 && out->data64;
+
+    // From one event time to the next, events at the same time in one go
+    bool     changed = false;
+    uint32_t next    = 0;
+    for (uint32_t first = 0; first < numFrames; )
+    {
+        bool due = false;
+        uint32_t end = numFrames;
+        for (; next < numEvents; next++)
+        {
+            const clap_event_header_t* header = events->get(events, next);
+            if (header->time > first)
+            {
+                end = std::min(end, header->time);
+                break;
+            }
+            due |= applyEvent(params, header);
+        }
+        // no table build per event time: the detector evaluates a changed
+        // curve itself until the next blocks bring its table
+        if (due)
+        {
+            params.prepare(SR);
+            changed = true;
+        }
+
+        if (numChannels > 0)
+        {
+            if (is64)
+                processRange<double>(in->data64, out->data64, numChannels, first, end - first);
+            else
+                processRange<float>(in->data32, out->data32, numChannels, first, end - first);
+        }
+        first = end;
+    }
+
+    // Events past the block, or a block without frames
+    bool due = false;
+    for (; next < numEvents; next++)
+        due |= applyEvent(params, events->get(events, next));
+    if (due)
+    {
+        params.prepare(SR);
+        changed = true;
+    }
+
+    if (changed)
+    {
+        // Hand the current set back for save and get_value
+        paramsFromAudio.back() = params;
+        paramsFromAudio.push();
+    }
+
+    // Loaded states bring their table along; for an automated curve the
+    // builder thread makes one while the detector evaluates it exactly
+    if (!core.curveReady(params))
+        curvesToAudio.want(params.f_threshold, params.f_knee, params.f_rs);
+    return CLAP_PROCESS_CONTINUE;
+}
+
+//------------------------------------------------------------------------
+template <typename SampleType>
+void VLC_CompClap::processRange(SampleType** inputs, SampleType** outputs, int32 numChannels,
+                                uint32_t first, uint32_t count)
+{
+    SampleType* in[AOUT_CHAN_MAX];
+    SampleType* out[AOUT_CHAN_MAX];
+    for (int32 ch = 0; ch < numChannels; ch++)
+    {
+        in[ch]  = inputs[ch] + first;
+        out[ch] = outputs[ch] + first;
+    }
+
+    //---in bypass mode outputs should be like inputs-----
+    // (also before activate laid out the delay line)
+    if (params.pBypass || !core.isReady())
+    {
+        for (int32 ch = 0; ch < numChannels; ch++)
+            if (in[ch] != out[ch])
+                std::memcpy(out[ch], in[ch], count * sizeof(SampleType));
+        return;
+    }
+
+    CompressorCore::NullObserver none;
+    core.process(in, out, numChannels, static_cast<int32>(count), params, none);
+}
+
+//------------------------------------------------------------------------
+void VLC_CompClap::flush(const clap_input_events_t* in)
+{
+    const uint32_t numEvents = in ? in->size(in) : 0;
+
+    // Active: called on the audio thread between blocks, like process()
+    if (active)
+    {
+        bool due = false;
+        for (uint32_t i = 0; i < numEvents; i++)
+            due |= applyEvent(params, in->get(in, i));
+        if (due)
+        {
+            params.prepare(SR);
+            paramsFromAudio.back() = params;
+            paramsFromAudio.push();
+        }
+        return;
+    }
+
+    // Inactive: main thread, the next activate() takes hostParams over.
+    // A new generation so nothing the audio thread sent before wins over it.
+    syncFromAudio();
+    bool due = false;
+    for (uint32_t i = 0; i < numEvents; i++)
+        due |= applyEvent(hostParams, in->get(in, i));
+    if (due)
+        hostParams.generation++;
+}
+
+//------------------------------------------------------------------------
+void VLC_CompClap::syncFromAudio()
+{
+    // Take the latest automated values, unless they predate the last load
+    if (paramsFromAudio.fetch() && paramsFromAudio.front().generation >= hostParams.generation)
+        hostParams = paramsFromAudio.front();
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::getValue(clap_id id, double* value)
+{
+    const ClapParam* param = findParam(id);
+    if (!param)
+        return false;
+
+    syncFromAudio();
+    StateValues current;
+    hostParams.toState(current);
+    *value = toPlain(*param, current.v[id]);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::valueToText(clap_id id, double value, char* text, uint32_t capacity)
+{
+    const ClapParam* param = findParam(id);
+    if (!param || capacity == 0)
+        return false;
+
+    if (param->stepped)
+        std::snprintf(text, capacity, "%s", value > 0.5 ? "On" : "Off");
+    else if (param->unit[0])
+        std::snprintf(text, capacity, "%.1f %s", value, param->unit);
+    else
+        std::snprintf(text, capacity, "%.1f", value);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::textToValue(clap_id id, const char* text, double* value)
+{
+    const ClapParam* param = findParam(id);
+    if (!param)
+        return false;
+
+    if (param->stepped && (!std::strcmp(text, "On") || !std::strcmp(text, "Off")))
+    {
+        *value = text[1] == 'n' ? 1.0 : 0.0;
+        return true;
+    }
+
+    // the number, units after it are ignored
+    char* end = nullptr;
+    const double v = std::strtod(text, &end);
+    if (end == text || !(v == v))
+        return false;
+    *value = LIMIT(v, param->min, param->max);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::load(const clap_istream_t* stream)
+{
+    ClapStream reader(stream);
+    StateValues saved;
+    if (!readState(&reader, saved))
+        return false;
+
+    // Build the whole set here, off the audio thread, then hand it over
+    CompParams& p = paramsToAudio.back();
+    p.fromState(saved);
+    p.generation  = hostParams.generation + 1;
+    p.prepare(SR);
+
+    // params first: a block in between runs them on the old table, which
+    // it won't take for theirs
+    hostParams = p;
+    paramsToAudio.push();
+
+    curvesToAudio.post(CurveCache::acquire(hostParams.f_threshold, hostParams.f_knee, hostParams.f_rs));
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VLC_CompClap::save(const clap_ostream_t* stream)
+{
+    syncFromAudio();
+
+    StateValues current;
+    hostParams.toState(current);
+
+    ClapStream writer(stream);
+    return writeState(&writer, current);
+}
+
+//------------------------------------------------------------------------
+const clap_plugin_factory_t kFactory = {
+    [](const clap_plugin_factory_t* /*factory*/) { return 1u; },
+    [](const clap_plugin_factory_t* /*factory*/, uint32_t index) {
+        return index == 0 ? &kDescriptor : nullptr;
+    },
+    [](const clap_plugin_factory_t* /*factory*/, const clap_host_t* host, const char* id) -> const clap_plugin_t* {
+        if (!clap_version_is_compatible(host->clap_version) || std::strcmp(id, kDescriptor.id))
+            return nullptr;
+        VLC_CompClap* plugin = new (std::nothrow) VLC_CompClap(host);
+        return plugin ? plugin->clapPlugin() : nullptr;
+    },
+};
+} // namespace
+
+//------------------------------------------------------------------------
+} // namespace yg331
+
+//------------------------------------------------------------------------
+// Module entry
+//------------------------------------------------------------------------
+extern "C" {
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    CLAP_VERSION_INIT,
+    [](const char* /*path*/) { return true; },
+    []() {},
+    [](const char* id) -> const void* {
+        return !std::strcmp(id, CLAP_PLUGIN_FACTORY_ID) ? &yg331::kFactory : nullptr;
+    },
+};
+
+} // extern "C"
@@ -4,21 +4,26 @@
 
 #include "VLCComp_controller.h"
 #include "VLCComp_cids.h"
+#include "VLCComp_state.h"
 
-#include "vstgui/plugin-bindings/vst3editor.h"
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/base/ustring.h"
 
+#if !VLCCOMP_HEADLESS
+#include "vstgui/plugin-bindings/vst3editor.h"
 #include "vstgui/vstgui_uidescription.h"
 #include "vstgui/uidescription/detail/uiviewcreatorattributes.h"
+#endif
 
 using namespace Steinberg;
 
+#if !VLCCOMP_HEADLESS
 static const std::string kAttrVuOnColor  = "vu-on-color";
 static const std::string kAttrVuOffColor = "vu-off-color";
 static const std::string kAttrPDclick    = "click-behave";
 static const std::string kAttrPDMin      = "update-min";
 static const std::string kAttrPDMax      = "update-max";
+static const std::string kAttrGrColor    = "gr-color";
 namespace VSTGUI {
 class MyVUMeterFactory : public ViewCreatorAdapter
 {
@@ -223,27 +228,168 @@ public:
     }
 };
 
+class HistoryViewFactory : public ViewCreatorAdapter
+{
+public:
+    HistoryViewFactory() { UIViewFactory::registerViewCreator(*this); }
+    IdStringPtr getViewName() const override { return "HistoryView"; }
+    IdStringPtr getBaseViewName() const override { return UIViewCreator::kCView; }
+    CView* create(const UIAttributes& attributes, const IUIDescription* description) const override
+    {
+        CRect ss(0, 0, 256, 100);
+        return new HistoryView(ss);
+    }
+    bool apply(CView* view, const UIAttributes& attributes, const IUIDescription* description) const SMTG_OVERRIDE
+    {
+        auto* vv = dynamic_cast<HistoryView*> (view);
+
+        if (!vv)
+            return false;
+
+        CColor color;
+        if (UIViewCreator::stringToColor(attributes.getAttributeValue(kAttrVuOnColor), color, description))
+            vv->setLevelColor(color);
+        if (UIViewCreator::stringToColor(attributes.getAttributeValue(kAttrVuOffColor), color, description))
+            vv->setBackColor(color);
+        if (UIViewCreator::stringToColor(attributes.getAttributeValue(kAttrGrColor), color, description))
+            vv->setGrColor(color);
+
+        return true;
+    }
+
+    bool getAttributeNames(StringList& attributeNames) const SMTG_OVERRIDE
+    {
+        attributeNames.emplace_back(kAttrVuOnColor);
+        attributeNames.emplace_back(kAttrVuOffColor);
+        attributeNames.emplace_back(kAttrGrColor);
+        return true;
+    }
+
+    AttrType getAttributeType(const std::string& attributeName) const SMTG_OVERRIDE
+    {
+        if (attributeName == kAttrVuOnColor || attributeName == kAttrVuOffColor || attributeName == kAttrGrColor)
+            return kColorType;
+        return kUnknownType;
+    }
+
+    bool getAttributeValue(
+        CView* view,
+        const string& attributeName,
+        string& stringValue,
+        const IUIDescription* desc) const SMTG_OVERRIDE
+    {
+        auto* vv = dynamic_cast<HistoryView*> (view);
+
+        if (!vv)
+            return false;
+
+        if (attributeName == kAttrVuOnColor)
+            UIViewCreator::colorToString(vv->getLevelColor(), stringValue, desc);
+        else if (attributeName == kAttrVuOffColor)
+            UIViewCreator::colorToString(vv->getBackColor(), stringValue, desc);
+        else if (attributeName == kAttrGrColor)
+            UIViewCreator::colorToString(vv->getGrColor(), stringValue, desc);
+        else
+            return false;
+        return true;
+    }
+};
+
+class TransferCurveViewFactory : public ViewCreatorAdapter
+{
+public:
+    TransferCurveViewFactory() { UIViewFactory::registerViewCreator(*this); }
+    IdStringPtr getViewName() const override { return "TransferCurveView"; }
+    IdStringPtr getBaseViewName() const override { return UIViewCreator::kCView; }
+    CView* create(const UIAttributes& attributes, const IUIDescription* description) const override
+    {
+        CRect ss(0, 0, 100, 100);
+        return new TransferCurveView(ss);
+    }
+    bool apply(CView* view, const UIAttributes& attributes, const IUIDescription* description) const SMTG_OVERRIDE
+    {
+        auto* vv = dynamic_cast<TransferCurveView*> (view);
+
+        if (!vv)
+            return false;
+
+        CColor color;
+        if (UIViewCreator::stringToColor(attributes.getAttributeValue(kAttrVuOnColor), color, description))
+            vv->setCurveColor(color);
+        if (UIViewCreator::stringToColor(attributes.getAttributeValue(kAttrVuOffColor), color, description))
+            vv->setBackColor(color);
+
+        return true;
+    }
+
+    bool getAttributeNames(StringList& attributeNames) const SMTG_OVERRIDE
+    {
+        attributeNames.emplace_back(kAttrVuOnColor);
+        attributeNames.emplace_back(kAttrVuOffColor);
+        return true;
+    }
+
+    AttrType getAttributeType(const std::string& attributeName) const SMTG_OVERRIDE
+    {
+        if (attributeName == kAttrVuOnColor || attributeName == kAttrVuOffColor)
+            return kColorType;
+        return kUnknownType;
+    }
+
+    bool getAttributeValue(
+        CView* view,
+        const string& attributeName,
+        string& stringValue,
+        const IUIDescription* desc) const SMTG_OVERRIDE
+    {
+        auto* vv = dynamic_cast<TransferCurveView*> (view);
+
+        if (!vv)
+            return false;
+
+        if (attributeName == kAttrVuOnColor)
+            UIViewCreator::colorToString(vv->getCurveColor(), stringValue, desc);
+        else if (attributeName == kAttrVuOffColor)
+            UIViewCreator::colorToString(vv->getBackColor(), stringValue, desc);
+        else
+            return false;
+        return true;
+    }
+};
+
 //create a static instance so that it registers itself with the view factory
 MyVUMeterFactory          __gMyVUMeterFactory;
 PDisplayFactory           __gPDisplayFactory;
 MeterViewContainerFactory __gMeterViewContainerFactory;
+HistoryViewFactory        __gHistoryViewFactory;
+TransferCurveViewFactory  __gTransferCurveViewFactory;
 } // namespace VSTGUI
 
 namespace yg331 {
 //------------------------------------------------------------------------
 // VuMeterController
 //------------------------------------------------------------------------
-template<> void VLC_CompController::UIVuMeterController::updateVuMeterValue()
+template<> void VLC_CompController::UIVuMeterController::updateVuMeterValue(bool metersChanged, bool historyChanged)
 {
     if (mainController) {
-        if (inMeter)     inMeter->    setValue(mainController->getVuMeterByTag(kIn));
-        if (outMeter)    outMeter->   setValue(mainController->getVuMeterByTag(kOut));
-        if (grMeter)     grMeter->    setValue(mainController->getVuMeterByTag(kGR));
-        if (vuMeterInL)  vuMeterInL-> setValue(mainController->getVuMeterByTag(vuMeterInL->getTag()));
-        if (vuMeterInR)  vuMeterInR-> setValue(mainController->getVuMeterByTag(vuMeterInR->getTag()));
-        if (vuMeterOutL) vuMeterOutL->setValue(mainController->getVuMeterByTag(vuMeterOutL->getTag()));
-        if (vuMeterOutR) vuMeterOutR->setValue(mainController->getVuMeterByTag(vuMeterOutR->getTag()));
-        if (vuMeterGR)   vuMeterGR->  setValue(mainController->getVuMeterByTag(kGR));
+        // the views skip anything below their hysteresis themselves
+        if (metersChanged) {
+            if (inMeter)     inMeter->    setValue(mainController->getVuMeterByTag(kIn));
+            if (outMeter)    outMeter->   setValue(mainController->getVuMeterByTag(kOut));
+            if (grMeter)     grMeter->    setValue(mainController->getVuMeterByTag(kGR));
+            if (vuMeterInL)  vuMeterInL-> setValue(mainController->getVuMeterByTag(vuMeterInL->getTag()));
+            if (vuMeterInR)  vuMeterInR-> setValue(mainController->getVuMeterByTag(vuMeterInR->getTag()));
+            if (vuMeterOutL) vuMeterOutL->setValue(mainController->getVuMeterByTag(vuMeterOutL->getTag()));
+            if (vuMeterOutR) vuMeterOutR->setValue(mainController->getVuMeterByTag(vuMeterOutR->getTag()));
+            if (vuMeterGR)   vuMeterGR->  setValue(mainController->getVuMeterByTag(kGR));
+        }
+        if (historyView && historyChanged) historyView->invalid();
+        if (curveView) {
+            ParamValue threshold, knee, rs;
+            mainController->getTransferCurve(threshold, knee, rs);
+            curveView->setCurve(threshold, knee, rs);
+            curveView->setLevel(mainController->getDetectorLevel());
+        }
     }
 }
 
@@ -322,6 +468,15 @@ template<> VSTGUI::CView* VLC_CompController::UIVuMeterController::verifyView(
             vuMeterGR->  registerViewListener(this);
         }
     }
+    if (HistoryView* control = dynamic_cast<HistoryView*>(view); control) {
+        historyView = control;
+        historyView->setHistory(&mainController->getHistory());
+        historyView->registerViewListener(this);
+    }
+    if (TransferCurveView* control = dynamic_cast<TransferCurveView*>(view); control) {
+        curveView = control;
+        curveView->registerViewListener(this);
+    }
 
     return view;
 }
@@ -337,8 +492,14 @@ template<> void VLC_CompController::UIVuMeterController::viewWillDelete(VSTGUI::
     if (dynamic_cast<MyVuMeter*>(view) == vuMeterOutL && vuMeterOutL) { vuMeterOutL->unregisterViewListener(this); vuMeterOutL = nullptr; }
     if (dynamic_cast<MyVuMeter*>(view) == vuMeterOutR && vuMeterOutR) { vuMeterOutR->unregisterViewListener(this); vuMeterOutR = nullptr; }
     if (dynamic_cast<MyVuMeter*>(view) == vuMeterGR   && vuMeterGR)   { vuMeterGR->  unregisterViewListener(this); vuMeterGR   = nullptr; }
+
+    if (dynamic_cast<HistoryView*>(view) == historyView     && historyView) { historyView->unregisterViewListener(this); historyView = nullptr; }
+    if (dynamic_cast<TransferCurveView*>(view) == curveView && curveView)   { curveView->  unregisterViewListener(this); curveView   = nullptr; }
 }
+} // namespace yg331
+#endif // !VLCCOMP_HEADLESS
 
+namespace yg331 {
 //------------------------------------------------------------------------
 // LogRangeParameter Declaration
 //------------------------------------------------------------------------
@@ -581,6 +742,28 @@ tresult PLUGIN_API VLC_CompController::initialize (FUnknown* context)
     flags        = Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList;
     parameters.addParameter(STR16("SoftBypass"), nullptr, stepCount, defaultVal, flags, tag);
 
+    // peak detector looks across the lookahead line, attack ends as the peak leaves it
+    tag          = kParamAnticipate;
+    stepCount    = 1;
+    defaultVal   = 0;
+    flags        = Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList;
+    parameters.addParameter(STR16("Anticipate"), nullptr, stepCount, defaultVal, flags, tag);
+
+    // Presets
+    presets = PresetLibrary::shared();
+
+    addUnit(new Vst::Unit(STR16("Root"), Vst::kRootUnitId, Vst::kNoParentUnitId, kParamProgram));
+    auto* programList = new Vst::ProgramList(STR16("Presets"), kParamProgram, Vst::kRootUnitId);
+    for (int32 i = 0; i < presets->size(); i++)
+    {
+        Vst::String128 name;
+        UString(name, str16BufferSize(Vst::String128)).fromAscii((*presets)[i].name);
+        programList->addProgram(name);
+    }
+    addProgramList(programList);
+    parameters.addParameter(programList->getParameter());
+
+#if !VLCCOMP_HEADLESS
     // GUI only parameter
     if (zoomFactors.empty())
     {
@@ -601,6 +784,7 @@ tresult PLUGIN_API VLC_CompController::initialize (FUnknown* context)
     zoomParameter->setNormalized(zoomParameter->toNormalized(0));
     zoomParameter->addDependent(this);
     uiParameters.addParameter(zoomParameter);
+#endif
 
 	return result;
 }
@@ -609,11 +793,20 @@ tresult PLUGIN_API VLC_CompController::initialize (FUnknown* context)
 tresult PLUGIN_API VLC_CompController::terminate ()
 {
 	// Here the Plug-in will be de-instantiated, last possibility to remove some memory!
+#if !VLCCOMP_HEADLESS
     getParameterObject(kParamZoom)->removeDependent(this);
     editors.clear();
     editors.shrink_to_fit();
     vuMeterControllers.clear();
     vuMeterControllers.shrink_to_fit();
+    if (meterTimer)
+    {
+        meterTimer->stop();
+        meterTimer = nullptr;
+    }
+    meterChannel = nullptr;
+#endif
+    presets = nullptr;
     
 	//---do not forget to call parent ------
 	return EditControllerEx1::terminate ();
@@ -626,52 +819,12 @@ tresult PLUGIN_API VLC_CompController::setComponentState (IBStream* state)
 	if (!state)
 		return kResultFalse;
 
-    IBStreamer streamer(state, kLittleEndian);
-
-    int32           savedBypass     = 0;
-    Vst::ParamValue savedZoom       = 0.0;
-    Vst::ParamValue savedOS         = 0.0;
-    Vst::ParamValue savedInput      = 0.0;
-    Vst::ParamValue savedOutput     = 0.0;
-    Vst::ParamValue savedRMS_PEAK   = 0.0;
-    Vst::ParamValue savedAttack     = 0.0;
-    Vst::ParamValue savedRelease    = 0.0;
-    Vst::ParamValue savedThreshold  = 0.0;
-    Vst::ParamValue savedRatio      = 0.0;
-    Vst::ParamValue savedKnee       = 0.0;
-    Vst::ParamValue savedMakeup     = 0.0;
-    Vst::ParamValue savedMix        = 0.0;
-    int32           savedSoftBypass = 0.0;
-    
-    if (streamer.readInt32 (savedBypass)     == false) savedBypass     = 0;
-    if (streamer.readDouble(savedZoom)       == false) savedZoom       = 2.0 / 6.0;
-    if (streamer.readDouble(savedOS)         == false) savedOS         = 0.0;
-    if (streamer.readDouble(savedInput)      == false) savedInput      = nrmInput;
-    if (streamer.readDouble(savedOutput)     == false) savedOutput     = nrmOutput;
-    if (streamer.readDouble(savedRMS_PEAK)   == false) savedRMS_PEAK   = nrmRMS_PEAK;
-    if (streamer.readDouble(savedAttack)     == false) savedAttack     = nrmAttack;
-    if (streamer.readDouble(savedRelease)    == false) savedRelease    = nrmRelease;
-    if (streamer.readDouble(savedThreshold)  == false) savedThreshold  = nrmThreshold;
-    if (streamer.readDouble(savedRatio)      == false) savedRatio      = nrmRatio;
-    if (streamer.readDouble(savedKnee)       == false) savedKnee       = nrmKnee;
-    if (streamer.readDouble(savedMakeup)     == false) savedMakeup     = nrmMakeup;
-    if (streamer.readDouble(savedMix)        == false) savedMix        = nrmMix;
-    if (streamer.readInt32 (savedSoftBypass) == false) savedSoftBypass = 0;
-
-    setParamNormalized(kParamBypass,     savedBypass ? 1 : 0);
-    setParamNormalized(kParamZoom,       savedZoom);
-    setParamNormalized(kParamOS,         savedOS);
-    setParamNormalized(kParamInput,      savedInput);
-    setParamNormalized(kParamOutput,     savedOutput);
-    setParamNormalized(kParamRMS_PEAK,   savedRMS_PEAK);
-    setParamNormalized(kParamAttack,     savedAttack);
-    setParamNormalized(kParamRelease,    savedRelease);
-    setParamNormalized(kParamThreshold,  savedThreshold);
-    setParamNormalized(kParamRatio,      savedRatio);
-    setParamNormalized(kParamKnee,       savedKnee);
-    setParamNormalized(kParamMakeup,     savedMakeup);
-    setParamNormalized(kParamMix,        savedMix);
-    setParamNormalized(kParamSoftBypass, savedSoftBypass ? 1 : 0);
+    StateValues saved;
+    if (!readState(state, saved))
+        return kResultFalse;
+
+    for (uint32 id = 0; id < kNumParams; id++)
+        setParamNormalized(id, saved.v[id]);
 
 	return kResultOk;
 }
@@ -693,6 +846,7 @@ tresult PLUGIN_API VLC_CompController::getState (IBStream* state)
 	return kResultTrue;
 }
 
+#if !VLCCOMP_HEADLESS
 //------------------------------------------------------------------------
 IPlugView* PLUGIN_API VLC_CompController::createView (FIDString name)
 {
@@ -712,7 +866,7 @@ IPlugView* PLUGIN_API VLC_CompController::createView (FIDString name)
         _zoomFactors.push_back(2.00);
         view->setAllowedZoomFactors(_zoomFactors);
         view->setZoomFactor(0.5);
-        view->setIdleRate(1000.0/60.0);
+        view->setIdleRate(1000.0/kMeterFrameRate);
         
         VSTGUI::CView::kDirtyCallAlwaysOnMainThread = true;
 
@@ -736,6 +890,7 @@ VSTGUI::IController* VLC_CompController::createSubController(
     }
     return nullptr;
 };
+#endif // !VLCCOMP_HEADLESS
 
 
 //------------------------------------------------------------------------
@@ -743,6 +898,25 @@ tresult PLUGIN_API VLC_CompController::setParamNormalized (Vst::ParamID tag, Vst
 {
 	// called by host to update your parameters
 	tresult result = EditControllerEx1::setParamNormalized (tag, value);
+
+    // The processor applies the preset itself at the next block,
+    // here we only mirror its values
+    if (tag == kParamProgram && result == kResultOk)
+    {
+        int32 index = presets ? presets->indexFromNormalized(value) : -1;
+        if (index >= 0)
+        {
+            const StateValues& preset = (*presets)[index].values;
+            for (uint32 id = 0; id < kNumParams; id++)
+            {
+                if (id == kParamBypass || id == kParamZoom)
+                    continue;
+                EditControllerEx1::setParamNormalized(id, preset.v[id]);
+            }
+            if (componentHandler)
+                componentHandler->restartComponent(Vst::kParamValuesChanged);
+        }
+    }
 	return result;
 }
 
@@ -762,17 +936,71 @@ tresult PLUGIN_API VLC_CompController::getParamValueByString (Vst::ParamID tag,
 	return EditControllerEx1::getParamValueByString (tag, string, valueNormalized);
 }
 
+#if !VLCCOMP_HEADLESS
 //------------------------------------------------------------------------
 void VLC_CompController::editorAttached(Vst::EditorView* editor)
 {
     editors.push_back(editor);
+
+    if (!meterTimer)
+    {
+        history.clear();
+        meterTimer = VSTGUI::makeOwned<VSTGUI::CVSTGUITimer> (
+            [this] (VSTGUI::CVSTGUITimer*) { pollMeters(); }, 1000 / kMeterFrameRate, true);
+    }
 }
 
 //------------------------------------------------------------------------
 void VLC_CompController::editorRemoved(Vst::EditorView* editor)
 {
     editors.erase(std::find(editors.begin(), editors.end(), editor));
+
+    if (editors.empty() && meterTimer)
+    {
+        meterTimer->stop();
+        meterTimer = nullptr;
+    }
 }
+
+//------------------------------------------------------------------------
+void VLC_CompController::pollMeters()
+{
+    bool metersChanged  = false;
+    bool historyChanged = false;
+
+    if (meterChannel)
+    {
+        // drain everything since the last tick, it's only a few points
+        HistoryPoint point;
+        while (meterChannel->history.pop(point))
+        {
+            history.add(point);
+            lastHistory = point;
+            historyChanged = true;
+        }
+
+        if (meterChannel->meters.fetch())
+        {
+            meters = meterChannel->meters.front();
+            metersChanged = true;
+        }
+    }
+
+    // also without audio, so the transfer curve follows the knobs
+    for (auto iter = vuMeterControllers.begin(); iter != vuMeterControllers.end(); iter++) {
+        (*iter)->updateVuMeterValue(metersChanged, historyChanged);
+    }
+}
+//------------------------------------------------------------------------
+void VLC_CompController::getTransferCurve(ParamValue& threshold, ParamValue& knee, ParamValue& rs)
+{
+    // same mapping as CompParams::prepare
+    const ParamValue ratio = Norm2Plain(getParamNormalized(kParamRatio), minRatio, maxRatio);
+    threshold = Norm2Plain(getParamNormalized(kParamThreshold), minThreshold, maxThreshold);
+    knee      = Norm2Plain(getParamNormalized(kParamKnee),      minKnee,      maxKnee);
+    rs        = (ratio - 1.0) / ratio;
+}
+
 //------------------------------------------------------------------------
 void PLUGIN_API VLC_CompController::update(FUnknown* changedUnknown, int32 message)
 {
@@ -807,33 +1035,16 @@ tresult PLUGIN_API VLC_CompController::notify(Vst::IMessage* message)
     if (!message)
         return kInvalidArgument;
     
-    if (strcmp (message->getMessageID (), "VUmeter") == 0)
-    {
-        double data = 0.0;
-        int64 update = 0.0;
-        if (message->getAttributes ()->getFloat ("vuInLRMS",    data) == kResultTrue) vuInLRMS    = data;
-        if (message->getAttributes ()->getFloat ("vuInRRMS",    data) == kResultTrue) vuInRRMS    = data;
-        if (message->getAttributes ()->getFloat ("vuInLPeak",    data) == kResultTrue) vuInLPeak    = data;
-        if (message->getAttributes ()->getFloat ("vuInRPeak",    data) == kResultTrue) vuInRPeak    = data;
-        if (message->getAttributes ()->getFloat ("tpIn",     data) == kResultTrue) tpIn     = data;
-        if (message->getAttributes ()->getFloat ("vuOutLRMS",   data) == kResultTrue) vuOutLRMS   = data;
-        if (message->getAttributes ()->getFloat ("vuOutRRMS",   data) == kResultTrue) vuOutRRMS   = data;
-        if (message->getAttributes ()->getFloat ("vuOutLPeak",   data) == kResultTrue) vuOutLPeak   = data;
-        if (message->getAttributes ()->getFloat ("vuOutRPeak",   data) == kResultTrue) vuOutRPeak   = data;
-        if (message->getAttributes ()->getFloat ("tpOut",    data) == kResultTrue) tpOut    = data;
-        if (message->getAttributes ()->getFloat ("vuGR",     data) == kResultTrue) vuGR     = data;
-        if (message->getAttributes ()->getInt   ("update", update) == kResultTrue) {
-            if (!vuMeterControllers.empty()) {
-                for (auto iter = vuMeterControllers.begin(); iter != vuMeterControllers.end(); iter++) {
-                    (*iter)->updateVuMeterValue();
-                }
-            }
-        }
-        
+    if (strcmp (message->getMessageID (), "MeterChannel") == 0)
+    {
+        int64 token = 0;
+        if (message->getAttributes ()->getInt ("token", token) == kResultTrue)
+            meterChannel = MeterChannel::find (token);
         return kResultOk;
     }
     return EditControllerEx1::notify(message);
 }
+#endif // !VLCCOMP_HEADLESS
 
 //------------------------------------------------------------------------
 } // namespace yg331
@@ -5,8 +5,16 @@
 #pragma once
 
 #include "VLCComp_shared.h"
+#include "VLCComp_presets.h"
 #include "public.sdk/source/vst/vsteditcontroller.h"
+
+// VLCCOMP_HEADLESS builds a processor-only module: the controller keeps the
+// parameters, program list and state, everything below is editor only.
+#if !VLCCOMP_HEADLESS
+#include "VLCComp_meters.h"
+#include "VLCComp_gaincurve.h"
 #include "vstgui/plugin-bindings/vst3editor.h"
+#include "vstgui/lib/cvstguitimer.h"
 
 namespace VSTGUI {
 class PDisplay : public CParamDisplay {
@@ -16,21 +24,23 @@ public:
         kUpdateMin = 1 << 0,
         kUpdateMax = 1 << 1,
     };
+    // below the display precision, a change wouldn't show
+    static constexpr float kHysteresisDb = 0.05f;
+
     PDisplay (const CRect& size, CBitmap* background = nullptr, int32_t style = 0)
         : CParamDisplay(size, background, style)
-    {setWantsIdle(true); originalBack = getBackColor();};
+    {originalBack = getBackColor();};
     PDisplay (const CParamDisplay& paramDisplay)
         : CParamDisplay(paramDisplay)
-    {setWantsIdle(true); originalBack = getBackColor();};
-    void onIdle() override {
-        invalid();
-    };
+    {originalBack = getBackColor();};
     void setValue(float val) override {
         directValue = val;
-        if (_style == kUpdateMax)
-            CParamDisplay::setValue(std::max(getValue(), val));
-        else
-            CParamDisplay::setValue(std::min(getValue(), val));
+        const float held = (_style == kUpdateMax) ? std::max(getValue(), val) : std::min(getValue(), val);
+        if (std::abs(held - getValue()) >= kHysteresisDb || (held > 0.f && getValue() <= 0.f))
+        {
+            CParamDisplay::setValue(held);
+            invalid();
+        }
         
         if (_style == kUpdateMax)
             if (getValue()>0.0)
@@ -46,6 +56,7 @@ public:
             over = false;
         }
         CParamDisplay::setValue(directValue);
+        invalid();
         CParamDisplay::onMouseDownEvent(event);
     };
     void setStyle_(int32_t newStyle) { _style = newStyle; }
@@ -95,8 +106,6 @@ public:
 
         rectOn(size.left, size.top, size.right, size.bottom);
         rectOff(size.left, size.top, size.right, size.bottom);
-
-        setWantsIdle(true);
     }
     MyVuMeter(const MyVuMeter& vuMeter)
         : CControl(vuMeter)
@@ -106,7 +115,6 @@ public:
         , rectOn(vuMeter.rectOn)
         , rectOff(vuMeter.rectOff)
     {
-        setWantsIdle(true);
     }
 
     void setStyle(int32_t newStyle) { style = newStyle; invalid(); }
@@ -127,42 +135,49 @@ public:
     {
         CView::setDirty(state);
     };
-    void draw(CDrawContext* _pContext) override {
+    // Values are in dB, smaller moves are ignored until they add up
+    static constexpr float kHysteresisDb = 0.25f;
 
-        CRect _rectOn(rectOn);
-        CRect _rectOff(rectOff);
-        CPoint pointOn;
-        CPoint pointOff;
-        CDrawContext* pContext = _pContext;
+    void setValue(float val) override {
+        if (std::abs(val - getValue()) < kHysteresisDb)
+            return;
+        CControl::setValue(val);
+        invalidBar();
+    };
+    void draw(CDrawContext* pContext) override {
 
         bounceValue();
 
-        float newValue = getValueNormalized(); // normalize
+        const CCoord length = barLength();
+        CRect _rectOn(rectOn);
+        CRect _rectOff(rectOff);
 
         if (style & kHorizontal)
         {
-            auto tmp = (CCoord)((int32_t)(newValue) * getViewSize().getWidth());
-            pointOff(tmp, 0);
-
-            _rectOff.left += tmp;
-            _rectOn.right = tmp + rectOn.left;
+            _rectOn.right = rectOn.left + length;
+            _rectOff.left = _rectOn.right;
         }
         else
         {
-            auto tmp = (CCoord)((int32_t)(newValue * getViewSize().getHeight()));
-            pointOn(0, tmp);
-
-            //_rectOff.bottom = tmp + rectOff.top;
-            //_rectOn.top += tmp;
-            _rectOn.top = _rectOff.bottom - tmp;
+            _rectOn.top = rectOff.bottom - length;
+            _rectOff.bottom = _rectOn.top;
         }
 
-        pContext->setFillColor(vuOffColor);
-        pContext->drawRect(rectOff, kDrawFilled);
-
-        pContext->setFillColor(vuOnColor);
-        pContext->drawRect(_rectOn, kDrawFilled);
+        // Only the invalidated strip is clipped in, don't fill the rest
+        CRect clip;
+        pContext->getClipRect(clip);
+        if (_rectOff.rectOverlap(clip))
+        {
+            pContext->setFillColor(vuOffColor);
+            pContext->drawRect(_rectOff.bound(clip), kDrawFilled);
+        }
+        if (_rectOn.rectOverlap(clip))
+        {
+            pContext->setFillColor(vuOnColor);
+            pContext->drawRect(_rectOn.bound(clip), kDrawFilled);
+        }
 
+        drawnLength = length;
         setDirty(false);
     };
     void setViewSize(const CRect& newSize, bool invalid = true) override
@@ -170,6 +185,7 @@ public:
         CControl::setViewSize(newSize, invalid);
         rectOn = getViewSize();
         rectOff = getViewSize();
+        drawnLength = -1.0;
     };
     bool sizeToFit() override {
         if (getDrawBackground())
@@ -183,11 +199,6 @@ public:
         }
         return false;
     };
-    
-    void onIdle() override {
-        invalid();
-    };
-    
 
     CLASS_METHODS(MyVuMeter, CControl)
 
@@ -205,10 +216,185 @@ protected:
 
     CRect    rectOn;
     CRect    rectOff;
+
+private:
+    // bar length in whole pixels, so sub-pixel moves don't redraw
+    CCoord barLength() const {
+        const CCoord size = (style & kHorizontal) ? getViewSize().getWidth() : getViewSize().getHeight();
+        return std::floor(LIMIT(getValueNormalized(), 0.f, 1.f) * size);
+    }
+    // invalidate only the strip between the drawn and the new bar end
+    void invalidBar() {
+        const CCoord length = barLength();
+        if (drawnLength < 0.0) { invalid(); return; }
+        if (length == drawnLength) return;
+
+        const CCoord lo = std::min(length, drawnLength);
+        const CCoord hi = std::max(length, drawnLength);
+        CRect strip(getViewSize());
+        if (style & kHorizontal)
+        {
+            strip.left  = getViewSize().left + lo;
+            strip.right = getViewSize().left + hi;
+        }
+        else
+        {
+            strip.top    = getViewSize().bottom - hi;
+            strip.bottom = getViewSize().bottom - lo;
+        }
+        invalidRect(strip);
+    }
+
+    CCoord drawnLength = -1.0; // nothing drawn yet
+};
+//------------------------------------------------------------------------
+//  Level / gain reduction history view
+//  Scrolls the controller's HistoryColumns, one min/max span per column:
+//  detector level rising from the bottom, gain reduction hanging from the
+//  top, on a shared dB scale.
+//------------------------------------------------------------------------
+class HistoryView : public CView {
+public:
+    static constexpr double kMinDb = -48.0;
+    static constexpr double kMaxDb = 6.0;
+
+    HistoryView(const CRect& size) : CView(size) {};
+
+    void setHistory(const yg331::HistoryColumns* newHistory) { history = newHistory; invalid(); }
+
+    void setLevelColor(CColor color) { if (levelColor != color) { levelColor = color; setDirty(true); } }
+    CColor getLevelColor() const { return levelColor; }
+    void setGrColor(CColor color) { if (grColor != color) { grColor = color; setDirty(true); } }
+    CColor getGrColor() const { return grColor; }
+    void setBackColor(CColor color) { if (backColor != color) { backColor = color; setDirty(true); } }
+    CColor getBackColor() const { return backColor; }
+
+    void draw(CDrawContext* pContext) override {
+        const CRect r = getViewSize();
+        pContext->setFillColor(backColor);
+        pContext->drawRect(r, kDrawFilled);
+
+        if (history)
+        {
+            using Columns = yg331::HistoryColumns;
+            const CCoord w = r.getWidth() / Columns::kColumns;
+            const CCoord h = r.getHeight();
+            auto levelY = [&](double db) { return r.bottom - h * (LIMIT(db, kMinDb, kMaxDb) - kMinDb) / (kMaxDb - kMinDb); };
+            auto grY    = [&](double db) { return r.top - h * LIMIT(db, kMinDb - kMaxDb, 0.0) / (kMaxDb - kMinDb); };
+
+            for (int i = 0; i < Columns::kColumns; i++)
+            {
+                const auto& c = (*history)[i];
+                const CCoord x = r.left + i * w;
+
+                pContext->setFillColor(levelColor);
+                pContext->drawRect(CRect(x, levelY(c.levelMax), x + w, std::max(levelY(c.levelMin), levelY(c.levelMax) + 1.0)), kDrawFilled);
+
+                if (c.grMin < 0.f)
+                {
+                    pContext->setFillColor(grColor);
+                    pContext->drawRect(CRect(x, r.top, x + w, grY(c.grMin)), kDrawFilled);
+                }
+            }
+        }
+        setDirty(false);
+    };
+
+    CLASS_METHODS(HistoryView, CView)
+
+protected:
+    const yg331::HistoryColumns* history = nullptr;
+    CColor levelColor = kWhiteCColor;
+    CColor grColor    = kRedCColor;
+    CColor backColor  = kBlackCColor;
+};
+//------------------------------------------------------------------------
+//  Transfer curve view
+//  Static input/output curve of the gain computer, one segment per pixel
+//  column, with a dot at the current detector level.
+//------------------------------------------------------------------------
+class TransferCurveView : public CView {
+public:
+    static constexpr double kMinDb = -48.0;
+    static constexpr double kMaxDb = 6.0;
+
+    TransferCurveView(const CRect& size) : CView(size) {};
+
+    void setCurve(double newThreshold, double newKnee, double newRs) {
+        if (threshold == newThreshold && knee == newKnee && rs == newRs)
+            return;
+        threshold = newThreshold;
+        knee      = newKnee;
+        rs        = newRs;
+        invalid();
+    }
+    void setLevel(double db) {
+        // only redraw for a visible move
+        if (std::abs(db - level) < 0.5)
+            return;
+        level = db;
+        invalid();
+    }
+
+    void setCurveColor(CColor color) { if (curveColor != color) { curveColor = color; setDirty(true); } }
+    CColor getCurveColor() const { return curveColor; }
+    void setBackColor(CColor color) { if (backColor != color) { backColor = color; setDirty(true); } }
+    CColor getBackColor() const { return backColor; }
+
+    void draw(CDrawContext* pContext) override {
+        const CRect r = getViewSize();
+        pContext->setFillColor(backColor);
+        pContext->drawRect(r, kDrawFilled);
+
+        const double range = kMaxDb - kMinDb;
+        auto toX   = [&](double db) { return r.left   + r.getWidth()  * (db - kMinDb) / range; };
+        auto toY   = [&](double db) { return r.bottom - r.getHeight() * (LIMIT(db, kMinDb, kMaxDb) - kMinDb) / range; };
+        auto outDb = [&](double db) { return db + yg331::GainCurve::curveDb(db, threshold, knee, rs); };
+
+        // unity reference
+        pContext->setFrameColor(MakeCColor(curveColor.red, curveColor.green, curveColor.blue, 64));
+        pContext->setLineWidth(1.0);
+        pContext->drawLine(CPoint(r.left, r.bottom), CPoint(r.right, r.top));
+
+        pContext->setFrameColor(curveColor);
+        pContext->setLineWidth(1.5);
+        CPoint prev(r.left, toY(kMinDb));
+        for (CCoord x = r.left + 1.0; x <= r.right; x += 1.0)
+        {
+            const double db = kMinDb + range * (x - r.left) / r.getWidth();
+            const CPoint next(x, toY(outDb(db)));
+            pContext->drawLine(prev, next);
+            prev = next;
+        }
+
+        if (level > kMinDb)
+        {
+            const CPoint dot(toX(std::min(level, kMaxDb)), toY(outDb(level)));
+            pContext->setFillColor(curveColor);
+            pContext->drawEllipse(CRect(dot.x - 3.0, dot.y - 3.0, dot.x + 3.0, dot.y + 3.0), kDrawFilled);
+        }
+        setDirty(false);
+    };
+
+    CLASS_METHODS(TransferCurveView, CView)
+
+protected:
+    double threshold = yg331::dftThreshold;
+    double knee      = yg331::dftKnee;
+    double rs        = (yg331::dftRatio - 1.0) / yg331::dftRatio;
+    double level     = -100.0;
+    CColor curveColor = kWhiteCColor;
+    CColor backColor  = kBlackCColor;
 };
 }
 
 namespace yg331 {
+// Meter refresh cap in Hz, drives both the meter poll timer and the editor idle
+#ifndef VLCCOMP_METER_FPS
+#define VLCCOMP_METER_FPS 30
+#endif
+static constexpr uint32 kMeterFrameRate = VLCCOMP_METER_FPS > 0 ? VLCCOMP_METER_FPS : 30;
+
 //------------------------------------------------------------------------
 // VuMeterController
 //------------------------------------------------------------------------
@@ -225,7 +411,9 @@ public:
         vuMeterInR(nullptr),
         vuMeterOutL(nullptr),
         vuMeterOutR(nullptr),
-        vuMeterGR(nullptr)
+        vuMeterGR(nullptr),
+        historyView(nullptr),
+        curveView(nullptr)
     {
     }
     ~VuMeterController() override
@@ -238,17 +426,21 @@ public:
         if (vuMeterOutL) viewWillDelete(vuMeterOutL);
         if (vuMeterOutR) viewWillDelete(vuMeterOutR);
         if (vuMeterGR)   viewWillDelete(vuMeterGR);
+        if (historyView) viewWillDelete(historyView);
+        if (curveView)   viewWillDelete(curveView);
 
         mainController->removeUIVuMeterController(this);
     }
 
-    void updateVuMeterValue();
+    void updateVuMeterValue(bool metersChanged, bool historyChanged);
 
 private:
     using CControl       = VSTGUI::CControl;
     using CView          = VSTGUI::CView;
     using PDisplay       = VSTGUI::PDisplay;
     using MyVuMeter      = VSTGUI::MyVuMeter;
+    using HistoryView    = VSTGUI::HistoryView;
+    using TransferCurveView = VSTGUI::TransferCurveView;
     using UTF8String     = VSTGUI::UTF8String;
     using UIAttributes   = VSTGUI::UIAttributes;
     using IUIDescription = VSTGUI::IUIDescription;
@@ -274,21 +466,30 @@ private:
     MyVuMeter* vuMeterOutL;
     MyVuMeter* vuMeterOutR;
     MyVuMeter* vuMeterGR;
+    HistoryView* historyView;
+    TransferCurveView* curveView;
 };
+} // namespace yg331
+#endif // !VLCCOMP_HEADLESS
 
+namespace yg331 {
 //------------------------------------------------------------------------
 //  VLC_CompController
 //------------------------------------------------------------------------
 class VLC_CompController
     : public Steinberg::Vst::EditControllerEx1
+#if !VLCCOMP_HEADLESS
     , public VSTGUI::VST3EditorDelegate
+#endif
 {
 public:
 //------------------------------------------------------------------------
 	VLC_CompController () = default;
 	~VLC_CompController () SMTG_OVERRIDE = default;
     
+#if !VLCCOMP_HEADLESS
     using UIVuMeterController = VuMeterController<VLC_CompController>;
+#endif
 
     // Create function
 	static Steinberg::FUnknown* createInstance (void* /*context*/)
@@ -302,7 +503,9 @@ public:
 
 	// EditController
 	Steinberg::tresult PLUGIN_API setComponentState (Steinberg::IBStream* state) SMTG_OVERRIDE;
+#if !VLCCOMP_HEADLESS
 	Steinberg::IPlugView* PLUGIN_API createView (Steinberg::FIDString name) SMTG_OVERRIDE;
+#endif
 	Steinberg::tresult PLUGIN_API setState (Steinberg::IBStream* state) SMTG_OVERRIDE;
 	Steinberg::tresult PLUGIN_API getState (Steinberg::IBStream* state) SMTG_OVERRIDE;
 	Steinberg::tresult PLUGIN_API setParamNormalized (Steinberg::Vst::ParamID tag,
@@ -314,6 +517,7 @@ public:
                                                          Steinberg::Vst::TChar* string,
                                                          Steinberg::Vst::ParamValue& valueNormalized) SMTG_OVERRIDE;
 
+#if !VLCCOMP_HEADLESS
     //---from VST3EditorDelegate-----------
     VSTGUI::IController* createSubController (VSTGUI::UTF8StringPtr name,
                                               const VSTGUI::IUIDescription* description,
@@ -326,6 +530,7 @@ public:
     void PLUGIN_API update(Steinberg::FUnknown* changedUnknown, Steinberg::int32 message) SMTG_OVERRIDE;
     void editorAttached(Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE; ///< called from EditorView if it was attached to a parent
     void editorRemoved (Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE; ///< called from EditorView if it was removed from a parent
+#endif
 
     //------------------------------------------------------------------------
     Steinberg::Vst::Parameter* getParameterObject(Steinberg::Vst::ParamID tag) SMTG_OVERRIDE
@@ -367,6 +572,7 @@ public:
         return Steinberg::kResultFalse;
     }
     
+#if !VLCCOMP_HEADLESS
     //---Internal functions-------
     void addUIVuMeterController(UIVuMeterController* controller)
     {
@@ -381,28 +587,33 @@ public:
     Steinberg::Vst::ParamValue getVuMeterByTag(Steinberg::Vst::ParamID tag)
    {
        switch (tag) {
-           case kIn:     return tpIn;    break;
-           case kInLRMS:    return vuInLRMS;    break;
-           case kInRRMS:    return vuInRRMS;    break;
-           case kInLPeak:    return vuInLPeak;    break;
-           case kInRPeak:    return vuInRPeak;    break;
-           case kOut:    return tpOut;   break;
-           case kOutLRMS:   return vuOutLRMS;   break;
-           case kOutRRMS:   return vuOutRRMS;   break;
-           case kOutLPeak:   return vuOutLPeak;   break;
-           case kOutRPeak:   return vuOutRPeak;   break;
-           case kGR:     return vuGR;     break;
+           case kIn:        return meters.tpIn;       break;
+           case kInLRMS:    return meters.vuInLRMS;   break;
+           case kInRRMS:    return meters.vuInRRMS;   break;
+           case kInLPeak:   return meters.vuInLPeak;  break;
+           case kInRPeak:   return meters.vuInRPeak;  break;
+           case kOut:       return meters.tpOut;      break;
+           case kOutLRMS:   return meters.vuOutLRMS;  break;
+           case kOutRRMS:   return meters.vuOutRRMS;  break;
+           case kOutLPeak:  return meters.vuOutLPeak; break;
+           case kOutRPeak:  return meters.vuOutRPeak; break;
+           case kGR:        return meters.vuGR;       break;
            default: break;
        }
        return 0;
    }
+    void pollMeters();
+    const HistoryColumns& getHistory() const { return history; }
+    ParamValue getDetectorLevel() const { return lastHistory.levelMax; }
+    void getTransferCurve(ParamValue& threshold, ParamValue& knee, ParamValue& rs);
+#endif
 
  	//---Interface---------
 	DEFINE_INTERFACES
 		// Here you can add more supported VST3 interfaces
 		// DEF_INTERFACE (Vst::IXXX)
-	END_DEFINE_INTERFACES (EditController)
-    DELEGATE_REFCOUNT (EditController)
+	END_DEFINE_INTERFACES (EditControllerEx1) // IUnitInfo for the program list
+    DELEGATE_REFCOUNT (EditControllerEx1)
 
 //------------------------------------------------------------------------
 protected:
@@ -410,6 +621,10 @@ protected:
     // UI only parameter list
     Steinberg::Vst::ParameterContainer uiParameters;
 
+    // factory + user presets, exposed as the root unit's program list
+    std::shared_ptr<const PresetLibrary> presets;   // shared with the processors
+
+#if !VLCCOMP_HEADLESS
     // editor list
     typedef std::vector<Steinberg::Vst::EditorView*> EditorVector;
     EditorVector editors;
@@ -429,12 +644,13 @@ protected:
     using UIVuMeterControllerList = std::vector<UIVuMeterController*>;
     UIVuMeterControllerList vuMeterControllers;
     
-    Steinberg::Vst::ParamValue vuInLRMS = 0.0, vuInRRMS = 0.0;
-    Steinberg::Vst::ParamValue vuInLPeak = 0.0, vuInRPeak = 0.0;
-    Steinberg::Vst::ParamValue vuOutLRMS = 0.0, vuOutRRMS = 0.0;
-    Steinberg::Vst::ParamValue vuOutLPeak = 0.0, vuOutRPeak = 0.0;
-    Steinberg::Vst::ParamValue vuGR = 0.0;
-    Steinberg::Vst::ParamValue tpIn = 0.0, tpOut = 0.0;
+    // metering, polled from the processor's channel while an editor is open
+    std::shared_ptr<MeterChannel> meterChannel;
+    VSTGUI::SharedPointer<VSTGUI::CVSTGUITimer> meterTimer;
+    MeterValues meters;
+    HistoryColumns history;
+    HistoryPoint   lastHistory;
+#endif
 };
 
 //------------------------------------------------------------------------
@@ -0,0 +1,299 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_core.h"
+
+#include <algorithm>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+// CompressorCore
+//------------------------------------------------------------------------
+uint32 CompressorCore::latencySamples(SampleRate SR)
+{
+    return Round( Clamp( SR * 0.01, 1.0, LOOKAHEAD_SIZE ) ); //10.0ms
+}
+
+//------------------------------------------------------------------------
+bool CompressorCore::setup(SampleRate SR, int32 numChannels, Quality newQuality)
+{
+    /* Calculate the RMS and lookahead sizes from the sample rate */
+    const ParamValue f_num = 0.01 * SR;
+    const uint32 i_decimate = newQuality == kOffline ? 1 : detectorDecimation(SR);
+    quality = newQuality;
+    hot.p_rms.i_count = Round( Clamp( 0.5 * f_num / i_decimate, 1.0, RMS_BUF_SIZE ) );
+    hot.p_la.i_count  = Round( Clamp( f_num, 1.0, LOOKAHEAD_SIZE ) );
+    hot.p_la.i_channels = static_cast<uint32>(std::min<int32>(std::max<int32>(numChannels, 0), AOUT_CHAN_MAX)); // lookahead frame width
+    hot.p_dec.i_factor  = i_decimate;
+
+    /* The level line in detector frames; decimated, two short for the
+     * gain interpolation (see decimate()) */
+    hot.p_la.i_lev_count = i_decimate > 1 ? std::max<uint32>(hot.p_la.i_count / i_decimate, 3) - 2
+                                          : hot.p_la.i_count;
+
+    /* Size the delay line and RMS window to exactly this setup, cleared */
+    const size_t valsCount = size_t(hot.p_la.i_count) * hot.p_la.i_channels;
+    hot.p_pw.i_size = hot.p_la.i_lev_count + 1; // the line and the frame leaving it
+    const size_t poolBytes = AlignedPool::footprint<DspSample>(hot.p_rms.i_count)
+                           + AlignedPool::footprint<DspSample>(valsCount)
+                           + AlignedPool::footprint<DspSample>(hot.p_la.i_lev_count)
+                           + AlignedPool::footprint<DspSample>(hot.p_pw.i_size)
+                           + AlignedPool::footprint<uint32>(hot.p_pw.i_size)
+                           + AlignedPool::footprint<DspSample>(hot.p_la.i_lev_count);
+    if (!pool.reserve(poolBytes))
+    {
+        release();
+        return false;
+    }
+    hot.p_rms.pf_buf    = pool.take<DspSample>(hot.p_rms.i_count);
+    hot.p_la.pf_vals    = valsCount ? pool.take<DspSample>(valsCount) : nullptr;
+    hot.p_la.pf_lev_in  = pool.take<DspSample>(hot.p_la.i_lev_count);
+    hot.p_pw.pf_max     = pool.take<DspSample>(hot.p_pw.i_size);
+    hot.p_pw.pi_at      = pool.take<uint32>(hot.p_pw.i_size);
+    hot.p_pw.pf_ramp    = pool.take<DspSample>(hot.p_la.i_lev_count);
+    reset();
+    return true;
+}
+
+//------------------------------------------------------------------------
+void CompressorCore::reset(uint64_t frameIndex)
+{
+    hot.f_sum      = 0.0;
+    hot.f_amp      = 0.0;
+    hot.f_gain     = 1.0;
+    hot.f_gain_out = 1.0;
+    hot.f_env      = 0.0;
+    hot.f_env_rms  = 0.0;
+    hot.f_env_peak = 0.0;
+    hot.i_count    = static_cast<uint32>(frameIndex / hot.p_dec.i_factor);
+
+    if (hot.p_rms.pf_buf)
+        std::fill(hot.p_rms.pf_buf, hot.p_rms.pf_buf + hot.p_rms.i_count, DspSample(0.0));
+    if (hot.p_la.pf_vals)
+        std::fill(hot.p_la.pf_vals, hot.p_la.pf_vals + size_t(hot.p_la.i_count) * hot.p_la.i_channels, DspSample(0.0));
+    if (hot.p_la.pf_lev_in)
+        std::fill(hot.p_la.pf_lev_in, hot.p_la.pf_lev_in + hot.p_la.i_lev_count, DspSample(0.0));
+    hot.p_rms.i_pos = 0;
+    hot.p_rms.f_sum = 0.0;
+    hot.p_la.i_pos  = 0;
+    hot.p_la.i_lev_pos = 0;
+
+    // the detector frames on the same grid as in a run from 0
+    hot.p_dec.f_max   = 0.0;
+    hot.p_dec.f_sum   = 0.0;
+    hot.p_dec.f_pow   = 0.0;
+    hot.p_dec.f_gain  = 1.0;
+    hot.p_dec.f_step  = 0.0;
+    hot.p_dec.i_phase = static_cast<uint32>(frameIndex % hot.p_dec.i_factor);
+
+    // primed from the cleared line when next used
+    hot.p_pw.i_head     = 0;
+    hot.p_pw.i_len      = 0;
+    hot.p_pw.i_ramp     = 0;
+    hot.p_pw.f_ramp_sum = 0.0;
+}
+
+//------------------------------------------------------------------------
+void CompressorCore::release()
+{
+    pool.release();
+    hot.p_rms = rms_env();
+    hot.p_la  = lookahead();
+    hot.p_pw  = peak_window();
+    hot.p_dec = decimator();
+}
+
+//------------------------------------------------------------------------
+uint64_t CompressorCore::warmUpSamples(SampleRate SR, const CompParams& params)
+{
+    // one-pole time constant in samples, -1 / ln(coef)
+    auto tau = [](double coef) { return (coef > 0.0 && coef < 1.0) ? -1.0 / std::log(coef) : 0.0; };
+    const double slowest = std::max(tau(params.f_ga), tau(params.f_gr));
+    const double decay   = std::log(1.0e6) * slowest;
+
+    // plus what the RMS window and the lookahead line hold
+    return static_cast<uint64_t>(std::ceil(decay)) + uint64_t(0.005 * SR) + 2 * latencySamples(SR);
+}
+
+//------------------------------------------------------------------------
+void CompressorCore::snapshot(State& s) const
+{
+    s.f_sum      = hot.f_sum;
+    s.f_amp      = hot.f_amp;
+    s.f_gain     = hot.f_gain;
+    s.f_gain_out = hot.f_gain_out;
+    s.f_env      = hot.f_env;
+    s.f_env_rms  = hot.f_env_rms;
+    s.f_env_peak = hot.f_env_peak;
+    s.i_count    = hot.i_count;
+    s.rms_pos    = hot.p_rms.i_pos;
+    s.rms_sum    = hot.p_rms.f_sum;
+    s.la_pos     = hot.p_la.i_pos;
+    s.lev_pos    = hot.p_la.i_lev_pos;
+    s.rms.assign(hot.p_rms.pf_buf, hot.p_rms.pf_buf + hot.p_rms.i_count);
+    s.lev_in.assign(hot.p_la.pf_lev_in, hot.p_la.pf_lev_in + hot.p_la.i_lev_count);
+    if (hot.p_la.pf_vals)
+        s.vals.assign(hot.p_la.pf_vals, hot.p_la.pf_vals + size_t(hot.p_la.i_count) * hot.p_la.i_channels);
+    else
+        s.vals.clear();
+    s.ramp_len = hot.p_pw.i_ramp;
+    s.ramp_sum = hot.p_pw.f_ramp_sum;
+    s.ramp.assign(hot.p_pw.pf_ramp, hot.p_pw.pf_ramp + hot.p_la.i_lev_count);
+    s.dec = hot.p_dec;
+}
+
+//------------------------------------------------------------------------
+bool CompressorCore::restore(const State& s)
+{
+    if (!isReady() || s.rms.size() != hot.p_rms.i_count || s.lev_in.size() != hot.p_la.i_lev_count
+        || s.vals.size() != size_t(hot.p_la.i_count) * hot.p_la.i_channels || s.ramp.size() != hot.p_la.i_lev_count
+        || s.dec.i_factor != hot.p_dec.i_factor)
+        return false;
+
+    hot.f_sum      = s.f_sum;
+    hot.f_amp      = s.f_amp;
+    hot.f_gain     = s.f_gain;
+    hot.f_gain_out = s.f_gain_out;
+    hot.f_env      = s.f_env;
+    hot.f_env_rms  = s.f_env_rms;
+    hot.f_env_peak = s.f_env_peak;
+    hot.i_count    = s.i_count;
+    hot.p_rms.i_pos = s.rms_pos;
+    hot.p_rms.f_sum = s.rms_sum;
+    hot.p_la.i_pos  = s.la_pos;
+    hot.p_la.i_lev_pos = s.lev_pos;
+    hot.p_dec       = s.dec;
+    std::copy(s.rms.begin(), s.rms.end(), hot.p_rms.pf_buf);
+    std::copy(s.lev_in.begin(), s.lev_in.end(), hot.p_la.pf_lev_in);
+    std::copy(s.vals.begin(), s.vals.end(), hot.p_la.pf_vals);
+    std::copy(s.ramp.begin(), s.ramp.end(), hot.p_pw.pf_ramp);
+    hot.p_pw.i_ramp     = s.ramp_len;
+    hot.p_pw.f_ramp_sum = s.ramp_sum;
+    rebuildWindow();
+    return true;
+}
+
+//------------------------------------------------------------------------
+// Anticipating detector, the parts off the per-sample path
+//------------------------------------------------------------------------
+void CompressorCore::rebuildWindow()
+{
+    /* The deque is a function of the levels in the line: push them again,
+     * oldest first, with the frames they came in at */
+    const uint32 i_count = hot.p_la.i_lev_count;
+    hot.p_pw.i_head = 0;
+    hot.p_pw.i_len  = 0;
+    for( uint32 k = 0, i = hot.p_la.i_lev_pos; k < i_count; k++ )
+    {
+        windowPush( hot.p_la.pf_lev_in[i], hot.i_count - i_count + k );
+        if( ++i == i_count ) i = 0;
+    }
+}
+
+void CompressorCore::primeWindow(const Coefs& c)
+{
+    /* Switched on mid-stream: the ramp starts out at the line's peak */
+    rebuildWindow();
+    const DspSample f_max = hot.p_pw.i_len > 0 ? hot.p_pw.pf_max[hot.p_pw.i_head] : DspSample(0.0);
+    std::fill( hot.p_pw.pf_ramp, hot.p_pw.pf_ramp + hot.p_la.i_lev_count, f_max );
+    hot.p_pw.f_ramp_sum = f_max * static_cast<DspSample>(c.i_ramp);
+    hot.p_pw.i_ramp     = c.i_ramp;
+}
+
+void CompressorCore::sumRamp(uint32 i_ramp, uint32 i_last)
+{
+    const uint32 i_count = hot.p_la.i_lev_count;
+    DspSample f_sum = 0.0;
+    for( uint32 k = 0, i = i_last; k < i_ramp; k++ )
+    {
+        f_sum += hot.p_pw.pf_ramp[i];
+        i = i > 0 ? i - 1 : i_count - 1;
+    }
+    hot.p_pw.f_ramp_sum = f_sum;
+    hot.p_pw.i_ramp     = i_ramp;
+}
+
+/*****************************************************************************
+ * Helper functions for compressor
+ *****************************************************************************/
+
+/* A set of branchless clipping operations from Laurent de Soras (Max is inline, in the header) */
+
+ParamValue CompressorCore::Clamp( ParamValue f_x, ParamValue f_a, ParamValue f_b )
+{
+    const ParamValue f_x1 = std::abs( f_x - f_a );
+    const ParamValue f_x2 = std::abs( f_x - f_b );
+
+    f_x = f_x1 + f_a + f_b;
+    f_x -= f_x2;
+    f_x *= 0.5;
+
+    return f_x;
+}
+
+/* Round float to int using IEEE int* hack */
+int CompressorCore::Round( float f_x )
+{
+    ls_pcast32 p;
+
+    p.f = f_x;
+    p.f += ( 3 << 22 );
+
+    return p.i - 0x4b400000;
+}
+
+/* Calculate current level from root-mean-squared of circular buffer ("RMS") */
+DspSample CompressorCore::RmsEnvProcess( rms_env * p_r, const DspSample f_x )
+{
+    /* Remove the old term from the sum */
+    p_r->f_sum -= p_r->pf_buf[p_r->i_pos];
+
+    /* Add the new term to the sum */
+    p_r->f_sum += f_x;
+
+    /* If the sum is small enough, make it zero */
+    if( p_r->f_sum < 1.0e-6f )
+    {
+        p_r->f_sum = 0.0f;
+    }
+
+    /* Replace the old term in the array with the new one */
+    p_r->pf_buf[p_r->i_pos] = f_x;
+
+    /* Go to the next position for the next RMS calculation */
+    p_r->i_pos = ( p_r->i_pos + 1 ) % ( p_r->i_count );
+
+    /* Return the RMS value */
+    return std::sqrt( p_r->f_sum / p_r->i_count );
+}
+
+/* Output the compressed delayed buffer and store the current buffer.
+ * Uses a circular array, just like the one used in calculating the RMS of the buffer
+ */
+void CompressorCore::BufferProcess(DspSample * pf_buf_in,
+                                   DspSample * pf_buf_out,
+                                   int i_channels,
+                                   DspSample f_gain,
+                                   DspSample f_mug,
+                                   lookahead * p_la )
+{
+    /* Loop through every channel */
+    for( int i_chan = 0; i_chan < i_channels; i_chan++ )
+    {
+        /* Current buffer value */
+        DspSample f_x = pf_buf_in[i_chan];
+
+        /* Output the compressed delayed buffer value */
+        pf_buf_out[i_chan] = p_la->pf_vals[p_la->i_pos * p_la->i_channels + i_chan] * f_gain * f_mug;
+
+        /* Update the delayed buffer value */
+        p_la->pf_vals[p_la->i_pos * p_la->i_channels + i_chan] = f_x;
+    }
+
+    /* Go to the next delayed buffer value for the next run */
+    p_la->i_pos = ( p_la->i_pos + 1 ) % ( p_la->i_count );
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,828 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_shared.h"
+#include "VLCComp_state.h"
+#include "VLCComp_gaincurve.h"
+#include "VLCComp_pool.h"
+#include "pluginterfaces/base/futils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#define decibelsToGain(f_db)  (std::pow(10.0, (f_db) / 20.0))
+#define gainToDecibels(f_lin) (((f_lin)>0)?(20.0 * log10(f_lin)):(-100.0))
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  Detector rate
+//  Envelopes and gain computer gain nothing audible from running faster
+//  than about 48 kHz. Above 88.2 kHz they run on a sidechain decimated by
+//  a power of two, at 44.1 to 96 kHz, so their cost per second stays put
+//  whatever the session rate. The audio path keeps the full rate.
+//------------------------------------------------------------------------
+inline uint32 detectorDecimation(Steinberg::Vst::SampleRate SR)
+{
+    uint32 i_decimate = 1;
+    while( i_decimate < 8 && SR >= 2.0 * 44100.0 * i_decimate )
+        i_decimate <<= 1;
+    return i_decimate;
+}
+
+//------------------------------------------------------------------------
+//  CompParams
+//  Normalized parameters plus the coefficients derived from them.
+//  prepare() does all the exp/pow work, so whoever builds a snapshot pays
+//  for it and processAudio only reads. Coefficients are cached against
+//  the parameter values and sample rate they came from.
+//------------------------------------------------------------------------
+struct CompParams
+{
+    using SampleRate = Steinberg::Vst::SampleRate;
+    using Sample64   = Steinberg::Vst::Sample64;
+
+    // Parameters (normalized)
+    bool       pBypass     = false;
+    ParamValue pInput      = nrmInput;
+    ParamValue pOutput     = nrmOutput;
+
+    ParamValue pRMS_PEAK   = nrmRMS_PEAK;
+    ParamValue pAttack     = nrmAttack;
+    ParamValue pRelease    = nrmRelease;
+    ParamValue pThreshold  = nrmThreshold;
+    ParamValue pRatio      = nrmRatio;
+    ParamValue pKnee       = nrmKnee;
+    ParamValue pMakeup     = nrmMakeup;
+    ParamValue pMix        = nrmMix;
+    bool       pSoftBypass = false;
+    bool       pAnticipate = false;
+
+    ParamValue pZoom       = 2.0 / 6.0;
+    ParamValue pOS         = 0.0;
+
+    // Derived coefficients
+    Sample64   inputGain   = 1.0;
+    Sample64   outputGain  = 1.0;
+    Sample64   f_threshold = dftThreshold; /* Threshold level (dB) */
+    Sample64   f_knee      = dftKnee;      /* Knee radius (dB)     */
+    Sample64   f_ga        = 0.0;          /* Attack coefficient   */
+    Sample64   f_gr        = 0.0;          /* Release coefficient  */
+    Sample64   f_rs        = 0.0;          /* Ratio slope          */
+    Sample64   f_mug       = 1.0;          /* Makeup gain (lin)    */
+    Sample64   f_knee_min  = 0.0;
+    Sample64   f_knee_max  = 0.0;
+    Sample64   f_ef_a      = 0.0;
+    uint32     i_attack    = 0;            /* Attack time (samples) */
+    Sample64   f_ga_dec    = 0.0;          /* The same three at the  */
+    Sample64   f_gr_dec    = 0.0;          /* detector rate, see     */
+    Sample64   f_ef_a_dec  = 0.0;          /* detectorDecimation()   */
+
+    // Bumped by every state load, so stale snapshots coming back from
+    // the audio thread can be told apart from the loaded one.
+    uint32     generation  = 0;
+
+    void fromState(const StateValues& s)
+    {
+        pBypass     = s.v[kParamBypass] > 0.5;
+        pZoom       = s.v[kParamZoom];
+        pOS         = static_cast<overSample>(Steinberg::FromNormalized<ParamValue> (s.v[kParamOS], overSample_num));
+        pInput      = s.v[kParamInput];
+        pOutput     = s.v[kParamOutput];
+        pRMS_PEAK   = s.v[kParamRMS_PEAK];
+        pAttack     = s.v[kParamAttack];
+        pRelease    = s.v[kParamRelease];
+        pThreshold  = s.v[kParamThreshold];
+        pRatio      = s.v[kParamRatio];
+        pKnee       = s.v[kParamKnee];
+        pMakeup     = s.v[kParamMakeup];
+        pMix        = s.v[kParamMix];
+        pSoftBypass = s.v[kParamSoftBypass] > 0.5;
+        pAnticipate = s.v[kParamAnticipate] > 0.5;
+    }
+
+    void toState(StateValues& s) const
+    {
+        s.v[kParamBypass]     = pBypass ? 1.0 : 0.0;
+        s.v[kParamZoom]       = pZoom;
+        s.v[kParamOS]         = Steinberg::ToNormalized<ParamValue> (static_cast<ParamValue>(pOS), overSample_num);
+        s.v[kParamInput]      = pInput;
+        s.v[kParamOutput]     = pOutput;
+        s.v[kParamRMS_PEAK]   = pRMS_PEAK;
+        s.v[kParamAttack]     = pAttack;
+        s.v[kParamRelease]    = pRelease;
+        s.v[kParamThreshold]  = pThreshold;
+        s.v[kParamRatio]      = pRatio;
+        s.v[kParamKnee]       = pKnee;
+        s.v[kParamMakeup]     = pMakeup;
+        s.v[kParamMix]        = pMix;
+        s.v[kParamSoftBypass] = pSoftBypass ? 1.0 : 0.0;
+        s.v[kParamAnticipate] = pAnticipate ? 1.0 : 0.0;
+    }
+
+    // Recomputes only the coefficients whose inputs differ from the ones
+    // they were last computed with. Returns false if nothing changed.
+    bool prepare(SampleRate SR)
+    {
+        bool dirty = false;
+        const bool srChanged = (key.sampleRate != SR);
+        key.sampleRate = SR;
+
+        if (key.input != pInput)
+        {
+            key.input = pInput;
+            inputGain = decibelsToGain(Norm2Plain(pInput, minInput, maxInput));
+            dirty = true;
+        }
+        if (key.output != pOutput)
+        {
+            key.output = pOutput;
+            outputGain = decibelsToGain(Norm2Plain(pOutput, minOutput, maxOutput));
+            dirty = true;
+        }
+        if (srChanged || key.attack != pAttack)
+        {
+            key.attack = pAttack;
+            Sample64 f_attack = LogNorm2Plain(pAttack, minAttack, maxAttack);    /* Attack time (ms)  */
+            f_ga   = f_attack < 2.0 ? 0.0 : exp(-1.0 / (SR * f_attack * 0.001));
+            f_ef_a = f_ga * 0.25;
+            i_attack = static_cast<uint32>(SR * f_attack * 0.001 + 0.5);
+            f_ga_dec   = f_attack < 2.0 ? 0.0 : exp(-1.0 / (detectorRate(SR) * f_attack * 0.001));
+            f_ef_a_dec = f_ga_dec * 0.25;
+            dirty = true;
+        }
+        if (srChanged || key.release != pRelease)
+        {
+            key.release = pRelease;
+            Sample64 f_release = Norm2Plain(pRelease, minRelease, maxRelease); /* Release time (ms) */
+            f_gr = exp(-1.0 / (SR * f_release * 0.001));
+            f_gr_dec = exp(-1.0 / (detectorRate(SR) * f_release * 0.001));
+            dirty = true;
+        }
+        if (key.ratio != pRatio)
+        {
+            key.ratio = pRatio;
+            Sample64 f_ratio = Norm2Plain(pRatio, minRatio, maxRatio);         /* Ratio (n:1)       */
+            f_rs = ( f_ratio - 1.0 ) / f_ratio;
+            dirty = true;
+        }
+        if (key.makeup != pMakeup)
+        {
+            key.makeup = pMakeup;
+            f_mug = decibelsToGain( Norm2Plain(pMakeup, minMakeup, maxMakeup) );
+            dirty = true;
+        }
+        if (key.threshold != pThreshold || key.knee != pKnee)
+        {
+            key.threshold = pThreshold;
+            key.knee      = pKnee;
+            f_threshold = Norm2Plain(pThreshold, minThreshold, maxThreshold);
+            f_knee      = Norm2Plain(pKnee,      minKnee,      maxKnee);
+            f_knee_min  = decibelsToGain( f_threshold - f_knee );
+            f_knee_max  = decibelsToGain( f_threshold + f_knee );
+            dirty = true;
+        }
+        return dirty;
+    }
+
+private:
+    static SampleRate detectorRate(SampleRate SR) { return SR / detectorDecimation(SR); }
+
+    // Inputs the coefficients above were computed from.
+    // Normalized values are never negative, so -1 forces the first update.
+    struct CoefKey
+    {
+        SampleRate sampleRate = 0.0;
+        ParamValue input      = -1.0;
+        ParamValue output     = -1.0;
+        ParamValue attack     = -1.0;
+        ParamValue release    = -1.0;
+        ParamValue threshold  = -1.0;
+        ParamValue ratio      = -1.0;
+        ParamValue knee       = -1.0;
+        ParamValue makeup     = -1.0;
+    } key;
+};
+
+//------------------------------------------------------------------------
+//  CompressorCore
+//  The compressor itself without any VST around it: detector, gain
+//  computer, lookahead line and their state. VLC_CompProcessor runs it
+//  with its meters hooked in, offline tools run it directly.
+//
+//  An Observer gets called from inside the sample loop and compiles away
+//  when its hooks are empty (see NullObserver):
+//    detector(f_env, f_gain)       every 4th detector frame, after the gain
+//                                  computer (4 * getDecimation() samples)
+//    sample(ch, in, out, f_gain)   each output sample, before soft bypass
+//------------------------------------------------------------------------
+class CompressorCore
+{
+public:
+    using SampleRate = Steinberg::Vst::SampleRate;
+
+    struct NullObserver
+    {
+        void detector(DspSample /*f_env*/, DspSample /*f_gain*/) {}
+        void sample(int32 /*ch*/, double /*in*/, double /*out*/, DspSample /*f_gain*/) {}
+    };
+
+    CompressorCore() = default;
+
+    /** process() runs in passes of this many frames, each one staged:
+     *  levels, then the detector, then the gain stage, over buffers that
+     *  stay in L1. Hosts' blocks get cut on the same grid (see
+     *  VLC_CompProcessor::process()). */
+    static constexpr int32 kSubBlock = 64;
+
+    /** Lookahead, and so latency, in samples: 10 ms. */
+    static uint32 latencySamples(SampleRate SR);
+
+    /** How much work the detector does per second of audio; the latency
+     *  is the same for both, so realtime and offline renders line up.
+     *  kRealtime:  sidechain decimated at high rates (detectorDecimation()),
+     *              gain computer every 4 detector frames, curve from the table
+     *  kOffline:   full rate, gain computer on every sample, the curve
+     *              computed exactly (GainCurve::processExact()) */
+    enum Quality { kRealtime, kOffline };
+
+    /** Sizes and clears the buffers for this rate and quality;
+     *  numChannels = 0 leaves out the audio delay line, for analyze()
+     *  only. Not realtime safe. */
+    bool setup(SampleRate SR, int32 numChannels, Quality quality = kRealtime);
+    void release();
+
+    /** Back to silence: envelopes, gain and buffers as after setup().
+     *  frameIndex is where in the stream the next sample sits, it keeps the
+     *  every-4 gain computer steps in phase with a run that started at 0. */
+    void reset(uint64_t frameIndex = 0);
+
+    bool isReady() const { return hot.p_la.pf_lev_in != nullptr; }
+    int32 getChannels() const { return static_cast<int32>(hot.p_la.i_channels); }
+    uint32 getDecimation() const { return hot.p_dec.i_factor; }  // audio frames per detector frame
+    Quality getQuality() const { return quality; }
+    size_t footprint() const { return pool.capacity() + (ownCurve ? sizeof(GainCurve) : 0); }   // heap only
+
+    DspSample getEnvelope() const { return hot.f_env; }  // detector level, linear
+    DspSample getGain() const { return hot.f_gain; }     // smoothed gain, linear
+    /** Anticipating detector's window, for vlccomp_check: its peak level
+     *  and how many detector frames it spans, the last one pushed included. */
+    DspSample getWindowPeak() const { return hot.p_pw.i_len > 0 ? hot.p_pw.pf_max[hot.p_pw.i_head] : DspSample(0.0); }
+    uint32 getWindowFrames() const { return hot.p_pw.i_size; }
+
+    /** The table in use, if any, see curveReady(). */
+    const GainCurve* getCurve() const { return hot.curve; }
+    /** Runs on a table owned elsewhere (see CurveCache), which the caller
+     *  keeps alive until the next setCurve(); nullptr goes back to the own
+     *  one, if updateCurve() ever built it. */
+    void setCurve(const GainCurve* shared) { hot.curve = shared ? shared : ownCurve.get(); }
+    /** Keeps the table in use if it fits params, else builds the own one
+     *  right away: offline tools. Allocates, not for the audio thread. */
+    void updateCurve(const CompParams& params)
+    {
+        if (curveReady(params))
+            return;
+        if (!ownCurve)
+            ownCurve.reset(new GainCurve);
+        if (!ownCurve->matches(params.f_threshold, params.f_knee, params.f_rs))
+            ownCurve->build(params.f_threshold, params.f_knee, params.f_rs);
+        hot.curve = ownCurve.get();
+    }
+    /** Whether the table in use fits params. Until one that does comes in
+     *  through setCurve(), which the plugins ask for off the audio thread
+     *  (see CurveFeed), the detector evaluates the curve itself
+     *  (GainCurve::processExact()): nothing is built on the audio thread. */
+    bool curveReady(const CompParams& params) const
+    {
+        return hot.curve && hot.curve->matches(params.f_threshold, params.f_knee, params.f_rs);
+    }
+
+    /** Compresses numChannels (<= getChannels()) of audio through the delay line.
+     *  Buffers is SampleType** or any view indexed the same way, [channel]
+     *  giving something with [frame] and + frames, e.g. a strided one
+     *  (see the C API); in place is fine. */
+    template <typename Buffers, typename Observer = NullObserver>
+    void process(Buffers inputs, Buffers outputs, int32 numChannels, int32 sampleFrames,
+                 const CompParams& params, Observer& observer);
+
+    /** Runs detector and delay line over a pre-roll without producing
+     *  output, so processing can pick up mid-stream: after reset(start)
+     *  and warmUp() over the warmUpSamples() before the cut, the state at
+     *  the cut matches a run from the very start to within about -120 dB. */
+    template <typename SampleType>
+    void warmUp(SampleType** inputs, int32 numChannels, int32 sampleFrames, const CompParams& params);
+
+    /** Pre-roll for warmUp(): the slower envelope decays by 10^-6 over it. */
+    static uint64_t warmUpSamples(SampleRate SR, const CompParams& params);
+
+    /** Copy of everything process() carries from one sample to the next.
+     *  Allocates, not for the audio thread. */
+    struct State
+    {
+        DspSample f_sum = 0.0, f_amp = 0.0, f_gain = 1.0, f_gain_out = 1.0;
+        DspSample f_env = 0.0, f_env_rms = 0.0, f_env_peak = 0.0;
+        uint32    i_count = 0;
+        uint32    rms_pos = 0, la_pos = 0, lev_pos = 0;
+        DspSample rms_sum = 0.0;
+        std::vector<DspSample> rms, vals, lev_in;
+        uint32    ramp_len = 0;             // anticipating detector, 0 if off
+        DspSample ramp_sum = 0.0;
+        std::vector<DspSample> ramp;        // its deque follows from lev_in
+        decimator dec;
+    };
+    void snapshot(State& state) const;
+    /** false if state was taken with another sample rate, channel count
+     *  or detector rate */
+    bool restore(const State& state);
+
+    /** Runs only the detector and gain computer, no delay line, gain
+     *  stage or output. The gain at sample n applies to output sample n,
+     *  i.e. to input sample n - latencySamples(). */
+    template <typename SampleType, typename Observer>
+    void analyze(SampleType** inputs, int32 numChannels, int32 sampleFrames,
+                 const CompParams& params, Observer& observer);
+
+private:
+    // Which detector loop runs, from setup(); see Quality
+    enum Mode { kFullRate, kDecimated, kExact };
+
+    // per-block copies, narrowed to the engine precision
+    struct Coefs
+    {
+        Coefs(const CompParams& p, uint32 i_lookahead, uint32 i_decimate, bool exact, bool tableCurve)
+            : inputGain (static_cast<DspSample>(p.inputGain))
+            , f_rms_peak(static_cast<DspSample>(p.pRMS_PEAK))
+            , f_ga      (static_cast<DspSample>(i_decimate > 1 ? p.f_ga_dec   : p.f_ga))
+            , f_gr      (static_cast<DspSample>(i_decimate > 1 ? p.f_gr_dec   : p.f_gr))
+            , f_ef_a    (static_cast<DspSample>(i_decimate > 1 ? p.f_ef_a_dec : p.f_ef_a))
+            , anticipate(p.pAnticipate)
+            , i_ramp    (rampLength(p.i_attack / i_decimate, i_lookahead))
+            , f_ramp_scale(DspSample(1.0) / static_cast<DspSample>(i_ramp))
+            , i_decimate(i_decimate)
+            , f_dec_scale(DspSample(1.0) / static_cast<DspSample>(i_decimate))
+            , peakMax   (p.pAnticipate || f_ga == DspSample(0.0))
+            , mode      (exact ? kExact : i_decimate > 1 ? kDecimated : kFullRate)
+            , f_threshold(p.f_threshold)
+            , f_knee    (p.f_knee)
+            , f_rs      (p.f_rs)
+            , tableCurve(tableCurve)
+        {}
+        const DspSample inputGain, f_rms_peak, f_ga, f_gr, f_ef_a;
+        const bool      anticipate;
+        const uint32    i_ramp;         // attack ramp, detector frames
+        const DspSample f_ramp_scale;   // 1 / i_ramp
+        const uint32    i_decimate;
+        const DspSample f_dec_scale;    // 1 / i_decimate
+        const bool      peakMax;        // decimated peak level, see decimate()
+        const Mode      mode;
+        const double    f_threshold, f_knee, f_rs;  // the curve, for processExact()
+        const bool      tableCurve;     // the table is built for them, see curveReady()
+    };
+    Coefs coefs(const CompParams& p) const
+    {
+        return Coefs(p, hot.p_la.i_lev_count, hot.p_dec.i_factor, quality == kOffline, curveReady(p));
+    }
+
+    /* The attack, done kRampMargin frames before the end of the line so
+     * the every-4 gain computer and the gain inertia catch up in time */
+    static constexpr uint32 kRampMargin = 8;
+    static uint32 rampLength(uint32 i_attack, uint32 i_lookahead)
+    {
+        const uint32 i_max = i_lookahead > kRampMargin ? i_lookahead - kRampMargin : 1;
+        return std::min(std::max(i_attack, uint32(1)), i_max);
+    }
+
+    template <typename SampleType>
+    DspSample level(SampleType** inputs, int32 numChannels, int32 i, const Coefs& c) const;
+    template <typename Buffers>
+    static void levels(const Buffers& inputs, int32 numChannels, int32 first, int32 count, const Coefs& c, DspSample* f_lev);
+
+    // Anticipate picks the peak detector and Mode the loop at compile
+    // time, the classic full rate one stays as it was. A decimated
+    // detector frame brings its mean square in f_pow_in_new.
+    template <bool Anticipate, Mode M, typename Observer>
+    void detect(DspSample f_lev_in_new, DspSample f_pow_in_new, const Coefs& c, Observer& observer);
+    template <bool Anticipate, typename Observer>
+    void decimate(const DspSample* f_lev, DspSample* f_gains, int32 count, const Coefs& c, Observer& observer);
+    template <bool Anticipate, Mode M, typename Observer>
+    void detectGains(const DspSample* f_lev, DspSample* f_gains, int32 count, const Coefs& c, Observer& observer);
+    template <Mode M, typename Observer>
+    void detectGains(const DspSample* f_lev, DspSample* f_gains, int32 count, const Coefs& c, Observer& observer)
+    {
+        if (c.anticipate) detectGains<true, M>(f_lev, f_gains, count, c, observer);
+        else              detectGains<false, M>(f_lev, f_gains, count, c, observer);
+    }
+    /* One audio frame through whichever detector c asks for, its gain back */
+    template <typename Observer>
+    DspSample detectFrame(DspSample f_lev, const Coefs& c, Observer& observer)
+    {
+        DspSample f_gain = 1.0;
+        switch (c.mode)
+        {
+        case kFullRate:  detectGains<kFullRate>(&f_lev, &f_gain, 1, c, observer); break;
+        case kDecimated: detectGains<kDecimated>(&f_lev, &f_gain, 1, c, observer); break;
+        case kExact:     detectGains<kExact>(&f_lev, &f_gain, 1, c, observer); break;
+        }
+        return f_gain;
+    }
+    DspSample peakAhead(DspSample f_lev_in_new, const Coefs& c);
+    void windowPush(DspSample f_lev, uint32 i_at);
+    void primeWindow(const Coefs& c);   // from the lookahead line, on switching on
+    void rebuildWindow();               // deque only, from the lookahead line
+    void sumRamp(uint32 i_ramp, uint32 i_last);  // pf_ramp up to i_last
+
+    void advance() { if( ++hot.p_la.i_pos == hot.p_la.i_count ) hot.p_la.i_pos = 0; }
+    void advanceLevel() { if( ++hot.p_la.i_lev_pos == hot.p_la.i_lev_count ) hot.p_la.i_lev_pos = 0; }
+
+    // Everything the sample loop reads and writes, on cache lines of its
+    // own: nothing cold shares them, nor does a neighbouring instance that
+    // another thread runs. Four lines, three in the float engine, the
+    // buffers live in the pool.
+    struct alignas(64) Hot
+    {
+        DspSample f_sum = 0.0;
+        DspSample f_amp = 0.0;
+        DspSample f_gain = 1.0;
+        DspSample f_gain_out = 1.0;
+        DspSample f_env = 0.0;
+        DspSample f_env_rms = 0.0;
+        DspSample f_env_peak = 0.0;
+        uint32   i_count = 0;
+
+        rms_env   p_rms;
+        lookahead p_la;
+        const GainCurve* curve = nullptr;
+        peak_window p_pw;
+        decimator p_dec;
+    } hot;
+
+    // Cold: touched by setup and parameter changes only
+    Quality quality = kRealtime;
+    std::unique_ptr<GainCurve> ownCurve; // offline tools only, built by updateCurve()
+    AlignedPool pool; // backs p_rms and p_la, laid out in setup()
+
+    typedef union
+    {
+        float f;
+        int32_t i;
+
+    } ls_pcast32;
+
+public:
+    static DspSample  Max             ( DspSample, DspSample );
+    static ParamValue Clamp           ( ParamValue, ParamValue, ParamValue );
+    static int        Round           ( float );
+    static DspSample  RmsEnvProcess   ( rms_env *, const DspSample );
+    static void       BufferProcess   ( DspSample *, DspSample *, int, DspSample, DspSample, lookahead * );
+};
+
+//------------------------------------------------------------------------
+// CompressorCore, inline parts of the sample loop
+//------------------------------------------------------------------------
+/* Branchless maximum from Laurent de Soras, inline so the level stage vectorizes */
+inline DspSample CompressorCore::Max( DspSample f_x, DspSample f_a )
+{
+    f_x -= f_a;
+    f_x += std::abs( f_x );
+    f_x *= DspSample(0.5);
+    f_x += f_a;
+
+    return f_x;
+}
+
+/* Find the peak value of current sample over all channels */
+template <typename SampleType>
+inline DspSample CompressorCore::level(SampleType** inputs, int32 numChannels, int32 i, const Coefs& c) const
+{
+    DspSample f_lev_in_new = std::abs( (DspSample) inputs[0][i] * c.inputGain);
+    for( int i_chan = 0; i_chan < numChannels; i_chan++ )
+    {
+        f_lev_in_new = Max( f_lev_in_new, std::abs( (DspSample) inputs[i_chan][i] * c.inputGain) );
+    }
+    return f_lev_in_new;
+}
+
+/* The same for count frames from first on, channel by channel */
+template <typename Buffers>
+inline void CompressorCore::levels(const Buffers& inputs, int32 numChannels, int32 first, int32 count,
+                                   const Coefs& c, DspSample* f_lev)
+{
+    auto in = inputs[0] + first;
+    for( int32 i = 0; i < count; i++ )
+        f_lev[i] = std::abs( (DspSample) in[i] * c.inputGain );
+    for( int32 i_chan = 0; i_chan < numChannels; i_chan++ )
+    {
+        in = inputs[i_chan] + first;
+        for( int32 i = 0; i < count; i++ )
+            f_lev[i] = Max( f_lev[i], std::abs( (DspSample) in[i] * c.inputGain ) );
+    }
+}
+
+template <bool Anticipate, CompressorCore::Mode M, typename Observer>
+inline void CompressorCore::detect(DspSample f_lev_in_new, DspSample f_pow_in_new, const Coefs& c, Observer& observer)
+{
+    /* Fetch the old delayed buffer value,
+     * the new one replaces it in the lookahead array */
+    const DspSample f_lev_in_old = hot.p_la.pf_lev_in[hot.p_la.i_lev_pos];
+    const DspSample f_lev_ahead  = Anticipate ? peakAhead( f_lev_in_new, c ) : DspSample(0.0);
+    hot.p_la.pf_lev_in[hot.p_la.i_lev_pos] = f_lev_in_new;
+
+    /* Add the square of the peak value to a running sum */
+    if( M == kDecimated )
+        hot.f_sum += f_pow_in_new;
+    else
+        hot.f_sum += f_lev_in_new * f_lev_in_new;
+
+    /* Update the RMS envelope */
+    if( hot.f_amp > hot.f_env_rms )
+    {
+        hot.f_env_rms = hot.f_env_rms * c.f_ga + hot.f_amp * ( DspSample(1.0) - c.f_ga );
+    }
+    else
+    {
+        hot.f_env_rms = hot.f_env_rms * c.f_gr + hot.f_amp * ( DspSample(1.0) - c.f_gr );
+    }
+
+    /* Update the peak envelope */
+    if( Anticipate )
+    {
+        /* Looking ahead, the ramp is the attack */
+        if( f_lev_ahead > hot.f_env_peak )
+        {
+            hot.f_env_peak = f_lev_ahead;
+        }
+        else
+        {
+            hot.f_env_peak = hot.f_env_peak * c.f_gr + f_lev_ahead * ( DspSample(1.0) - c.f_gr );
+        }
+    }
+    else if( f_lev_in_old > hot.f_env_peak )
+    {
+        hot.f_env_peak = hot.f_env_peak * c.f_ga + f_lev_in_old * ( DspSample(1.0) - c.f_ga );
+    }
+    else
+    {
+        hot.f_env_peak = hot.f_env_peak * c.f_gr + f_lev_in_old * ( DspSample(1.0) - c.f_gr );
+    }
+
+    /* Offline, the output gain follows every sample, from the curve itself */
+    if( M == kExact )
+    {
+        hot.f_env      = LIN_INTERP( c.f_rms_peak, hot.f_env_rms, hot.f_env_peak );
+        hot.f_gain_out = GainCurve::processExact( hot.f_env, c.f_threshold, c.f_knee, c.f_rs );
+    }
+
+    /* Process the RMS value and update the output gain every 4 samples */
+    if( ( hot.i_count++ & 3 ) == 3 )
+    {
+        /* Process the RMS value by placing in the mean square value, and reset the running sum */
+        hot.f_amp = RmsEnvProcess( &hot.p_rms, hot.f_sum * DspSample(0.25) );
+        hot.f_sum = 0.0;
+        if( std::isnan( hot.f_env_rms ) )
+        {
+            /* This can happen sometimes, but I don't know why. */
+            hot.f_env_rms = 0.0;
+        }
+
+        if( M != kExact )
+        {
+            /* Find the superposition of the RMS and peak envelopes */
+            hot.f_env = LIN_INTERP( c.f_rms_peak, hot.f_env_rms, hot.f_env_peak );
+
+            /* Update the output gain from the static curve table, or from
+             * the curve itself until the table catches up with a change */
+            hot.f_gain_out = c.tableCurve ? hot.curve->process( hot.f_env )
+                                          : GainCurve::processExact( hot.f_env, c.f_threshold, c.f_knee, c.f_rs );
+        }
+
+        observer.detector( hot.f_env, hot.f_gain );
+    }
+
+    /* Find the total gain */
+    hot.f_gain = hot.f_gain * c.f_ef_a + hot.f_gain_out * (DspSample(1.0) - c.f_ef_a); //inertia to the gain change, with quater of attack
+}
+
+/* Anticipating detector: the peak of the lookahead line, new level
+ * included, averaged over the last i_ramp frames. A transient entering
+ * the line ramps the level up linearly and the ramp tops out before the
+ * transient leaves it. Amortized O(1): every level enters and leaves the
+ * deque once. */
+inline void CompressorCore::windowPush( DspSample f_lev, uint32 i_at )
+{
+    peak_window& w = hot.p_pw;
+
+    /* The level that left the window from the front, one at most, before
+     * the new one takes a slot: a full deque holds i_size levels */
+    if( w.i_len > 0 && i_at - w.pi_at[w.i_head] >= w.i_size )
+    {
+        if( ++w.i_head == w.i_size ) w.i_head = 0;
+        w.i_len--;
+    }
+
+    /* Drop the levels the new one covers from the back */
+    while( w.i_len > 0 )
+    {
+        uint32 i_back = w.i_head + w.i_len - 1;
+        if( i_back >= w.i_size ) i_back -= w.i_size;
+        if( w.pf_max[i_back] > f_lev ) break;
+        w.i_len--;
+    }
+    uint32 i_tail = w.i_head + w.i_len;
+    if( i_tail >= w.i_size ) i_tail -= w.i_size;
+    w.pf_max[i_tail] = f_lev;
+    w.pi_at[i_tail]  = i_at;
+    w.i_len++;
+}
+
+inline DspSample CompressorCore::peakAhead( DspSample f_lev_in_new, const Coefs& c )
+{
+    peak_window& w = hot.p_pw;
+    if( w.i_ramp == 0 )
+        primeWindow( c );
+    else if( w.i_ramp != c.i_ramp )
+        sumRamp( c.i_ramp, hot.p_la.i_lev_pos > 0 ? hot.p_la.i_lev_pos - 1 : hot.p_la.i_lev_count - 1 );
+
+    /* Peak of the line: the frame leaving it through the new one */
+    windowPush( f_lev_in_new, hot.i_count );
+    const DspSample f_max = w.pf_max[w.i_head];
+
+    /* Moving average of the last i_ramp peaks */
+    const uint32 i_pos   = hot.p_la.i_lev_pos;
+    const uint32 i_count = hot.p_la.i_lev_count;
+    const uint32 i_old   = i_pos >= c.i_ramp ? i_pos - c.i_ramp : i_pos + i_count - c.i_ramp;
+    w.f_ramp_sum += f_max - w.pf_ramp[i_old];
+    w.pf_ramp[i_pos] = f_max;
+
+    /* Once around the line, sum afresh so rounding can't pile up */
+    if( i_pos == i_count - 1 )
+        sumRamp( c.i_ramp, i_pos );
+
+    return w.f_ramp_sum * c.f_ramp_scale;
+}
+
+/* Decimated detector: gathers i_decimate audio frames into one detector
+ * frame, their mean square for the RMS envelope and for the peak one
+ * their mean level, which the attack averages the same as it would the
+ * frames one by one. Without that averaging, an instant attack or the
+ * anticipating detector, it takes their peak so none goes missing.
+ * The gain ramps from the detector gain before last to the last one over
+ * the next i_decimate frames; the level line is two detector frames
+ * short of the audio one (see setup()), so the ramp is done when the
+ * frames it was measured on reach the output.
+ * Takes count frames, the rest of the detector frame at most. */
+template <bool Anticipate, typename Observer>
+inline void CompressorCore::decimate(const DspSample* f_lev, DspSample* f_gains, int32 count,
+                                     const Coefs& c, Observer& observer)
+{
+    decimator& d = hot.p_dec;
+    DspSample f_max = d.f_max, f_sum = d.f_sum, f_pow = d.f_pow;
+    const DspSample f_from = d.f_gain, f_step = d.f_step;
+    const uint32    i_from = d.i_phase + 1;
+    for( int32 i = 0; i < count; i++ )
+    {
+        f_max  = Max( f_max, f_lev[i] );
+        f_sum += f_lev[i];
+        f_pow += f_lev[i] * f_lev[i];
+        f_gains[i] = f_from + f_step * static_cast<DspSample>( i_from + i );
+    }
+
+    d.i_phase += static_cast<uint32>( count );
+    if( d.i_phase < c.i_decimate )
+    {
+        d.f_max = f_max;
+        d.f_sum = f_sum;
+        d.f_pow = f_pow;
+        return;
+    }
+
+    d.f_gain = hot.f_gain;
+    detect<Anticipate, kDecimated>( c.peakMax ? f_max : f_sum * c.f_dec_scale, f_pow * c.f_dec_scale, c, observer );
+    advanceLevel();
+    d.f_step  = ( hot.f_gain - d.f_gain ) * c.f_dec_scale;
+    d.f_max   = 0.0;
+    d.f_sum   = 0.0;
+    d.f_pow   = 0.0;
+    d.i_phase = 0;
+}
+
+template <bool Anticipate, CompressorCore::Mode M, typename Observer>
+inline void CompressorCore::detectGains(const DspSample* f_lev, DspSample* f_gains, int32 count,
+                                        const Coefs& c, Observer& observer)
+{
+    if( M == kDecimated )
+    {
+        /* A detector frame at a time, the first and last maybe in part */
+        for( int32 i = 0; i < count; )
+        {
+            const int32 n = std::min( static_cast<int32>( c.i_decimate - hot.p_dec.i_phase ), count - i );
+            decimate<Anticipate>( f_lev + i, f_gains + i, n, c, observer );
+            i += n;
+        }
+        return;
+    }
+
+    for( int32 i = 0; i < count; i++ )
+    {
+        detect<Anticipate, M>( f_lev[i], DspSample(0.0), c, observer );
+        f_gains[i] = hot.f_gain;
+        advanceLevel();
+    }
+}
+
+template <typename Buffers, typename Observer>
+void CompressorCore::process(Buffers inputs, Buffers outputs, int32 numChannels, int32 sampleFrames,
+                             const CompParams& params, Observer& observer)
+{
+    const Coefs c = coefs(params);
+    if( !c.anticipate ) hot.p_pw.i_ramp = 0;   // primed afresh when switched back on
+    const DspSample outputGain = static_cast<DspSample>(params.outputGain);
+    const DspSample f_mug      = static_cast<DspSample>(params.f_mug);
+    const DspSample f_mix      = static_cast<DspSample>(params.pMix);
+    const bool      softBypass = params.pSoftBypass;
+
+    alignas(64) DspSample f_lev[kSubBlock];
+    alignas(64) DspSample f_gains[kSubBlock];
+
+    /* Process the current buffer, a sub-block at a time */
+    for( int32 first = 0; first < sampleFrames; first += kSubBlock )
+    {
+        const int32 count = std::min( kSubBlock, sampleFrames - first );
+
+        /* Peak levels, free of the recursion, so over whole sub-blocks */
+        levels( inputs, numChannels, first, count, c, f_lev );
+
+        /* Now, compress the pre-equalized audio (ported from sc4_1882 plugin with a few modifications) */
+        switch( c.mode )
+        {
+        case kFullRate:  detectGains<kFullRate>( f_lev, f_gains, count, c, observer ); break;
+        case kDecimated: detectGains<kDecimated>( f_lev, f_gains, count, c, observer ); break;
+        case kExact:     detectGains<kExact>( f_lev, f_gains, count, c, observer ); break;
+        }
+
+        /* Write the resulting buffer to the output */
+        //BufferProcess( inputs, outputs, i_channels, f_gain, f_mug, p_la );
+        for( int32 j = 0; j < count; j++ )
+        {
+            const int32     i      = first + j;
+            const DspSample f_gain = f_gains[j];
+            DspSample* pf_vals = hot.p_la.pf_vals + hot.p_la.i_pos * hot.p_la.i_channels;
+            for( int i_chan = 0; i_chan < numChannels; i_chan++ )
+            {
+                /* Current buffer value */
+                DspSample f_x = static_cast<DspSample>(inputs[i_chan][i]);
+
+                /* Output the compressed delayed buffer value, rounded in the
+                 * engine's precision whatever the host's buffers hold */
+                DspSample f_y = pf_vals[i_chan] * f_gain * f_mug * c.inputGain;
+                f_y = f_y * f_mix + pf_vals[i_chan] * (DspSample(1.0) - f_mix);
+                f_y *= outputGain;
+                outputs[i_chan][i] = f_y;
+
+                observer.sample( i_chan, f_x, outputs[i_chan][i], f_gain );
+
+                // BYPASS
+                if(softBypass) outputs[i_chan][i] = pf_vals[i_chan];
+
+                /* Update the delayed buffer value */
+                pf_vals[i_chan] = f_x;
+            }
+
+            /* Go to the next delayed buffer value for the next run */
+            advance();
+        }
+    }
+}
+
+template <typename SampleType>
+void CompressorCore::warmUp(SampleType** inputs, int32 numChannels, int32 sampleFrames, const CompParams& params)
+{
+    const Coefs  c = coefs(params);
+    NullObserver none;
+    if( !c.anticipate ) hot.p_pw.i_ramp = 0;
+    for( int i = 0; i < sampleFrames; i++ )
+    {
+        detectFrame( level( inputs, numChannels, i, c ), c, none );
+
+        DspSample* pf_vals = hot.p_la.pf_vals + hot.p_la.i_pos * hot.p_la.i_channels;
+        for( int i_chan = 0; i_chan < numChannels; i_chan++ )
+            pf_vals[i_chan] = static_cast<DspSample>(inputs[i_chan][i]);
+
+        advance();
+    }
+}
+
+template <typename SampleType, typename Observer>
+void CompressorCore::analyze(SampleType** inputs, int32 numChannels, int32 sampleFrames,
+                             const CompParams& params, Observer& observer)
+{
+    const Coefs c = coefs(params);
+    if( !c.anticipate ) hot.p_pw.i_ramp = 0;
+    for( int i = 0; i < sampleFrames; i++ )
+        detectFrame( level( inputs, numChannels, i, c ), c, observer );
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
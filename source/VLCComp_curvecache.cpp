@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_curvecache.h"
+#include "VLCComp_rtcheck.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+// shared tables by settings, never touched from the audio thread
+//------------------------------------------------------------------------
+namespace {
+using CurveKey = std::tuple<double, double, double>; // threshold, knee, rs
+
+struct Registry
+{
+    std::mutex lock;
+    std::map<CurveKey, std::weak_ptr<const GainCurve>> curves;
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+} // namespace
+
+//------------------------------------------------------------------------
+// CurveCache
+//------------------------------------------------------------------------
+CurveCache::Handle CurveCache::acquire(double f_threshold, double f_knee, double f_rs)
+{
+    const CurveKey key(f_threshold, f_knee, f_rs);
+
+    Registry& r = registry();
+    RT_LOCK_CHECK();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    auto& slot = r.curves[key];
+    if (Handle curve = slot.lock())
+        return curve;
+
+    // the last handle takes the entry out again, unless a newer table
+    // for the same settings has replaced it meanwhile
+    GainCurve* table = new GainCurve;
+    table->build(f_threshold, f_knee, f_rs);
+    Handle curve(table, [key](const GainCurve* p) {
+        {
+            Registry& r = registry();
+            RT_LOCK_CHECK();
+            std::lock_guard<std::mutex> guard(r.lock);
+            auto it = r.curves.find(key);
+            if (it != r.curves.end() && it->second.expired())
+                r.curves.erase(it);
+        }
+        delete p;
+    });
+    slot = curve;
+    return curve;
+}
+
+//------------------------------------------------------------------------
+size_t CurveCache::size()
+{
+    Registry& r = registry();
+    RT_LOCK_CHECK();
+    std::lock_guard<std::mutex> guard(r.lock);
+    return r.curves.size();
+}
+
+//------------------------------------------------------------------------
+//  CurveBuilder
+//  The thread behind every CurveFeed in the module. The audio threads
+//  can't wake it without a lock or a syscall, so it looks at the feeds
+//  every kPeriod; a curve that changed runs exactly for that long at most.
+//  Runs while there are feeds, so no thread outlives the last instance
+//  into module unload.
+//------------------------------------------------------------------------
+struct CurveBuilder
+{
+    static constexpr std::chrono::milliseconds kPeriod {5};
+
+    std::mutex              lifecycle;  // attach/detach, around start and join
+    std::mutex              lock;       // feeds, stop
+    std::condition_variable wake;
+    std::vector<CurveFeed*> feeds;
+    std::thread             thread;
+    bool                    stop = false;
+
+    static CurveBuilder& get()
+    {
+        // never destroyed: a feed leaked past exit mustn't find it gone
+        static CurveBuilder* builder = new CurveBuilder;
+        return *builder;
+    }
+
+    void attach(CurveFeed* feed)
+    {
+        std::lock_guard<std::mutex> life(lifecycle);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            feeds.push_back(feed);
+            stop = false;
+        }
+        if (!thread.joinable())
+            thread = std::thread([this] { run(); });
+    }
+
+    void detach(CurveFeed* feed)
+    {
+        std::lock_guard<std::mutex> life(lifecycle);
+        bool last;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            feeds.erase(std::remove(feeds.begin(), feeds.end(), feed), feeds.end());
+            last = feeds.empty();
+            stop = last;
+        }
+        if (last && thread.joinable())
+        {
+            wake.notify_one();
+            thread.join();
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stop)
+        {
+            for (CurveFeed* feed : feeds)
+                feed->serve();
+            wake.wait_for(guard, kPeriod);
+        }
+    }
+};
+
+//------------------------------------------------------------------------
+// CurveFeed
+//------------------------------------------------------------------------
+CurveFeed::CurveFeed()
+{
+    CurveBuilder::get().attach(this);
+}
+
+//------------------------------------------------------------------------
+CurveFeed::~CurveFeed()
+{
+    CurveBuilder::get().detach(this);
+}
+
+//------------------------------------------------------------------------
+void CurveFeed::post(CurveCache::Handle curve)
+{
+    RT_LOCK_CHECK();
+    std::lock_guard<std::mutex> guard(postLock);
+    toAudio.back() = std::move(curve);
+    toAudio.push();
+}
+
+//------------------------------------------------------------------------
+void CurveFeed::want(double f_threshold, double f_knee, double f_rs)
+{
+    Key key;
+    key.threshold = f_threshold;
+    key.knee      = f_knee;
+    key.rs        = f_rs;
+    if (key == lastWanted)
+        return;
+    lastWanted    = key;
+    wanted.back() = key;
+    wanted.push();
+}
+
+//------------------------------------------------------------------------
+bool CurveFeed::fetch()
+{
+    if (!toAudio.fetch())
+        return false;
+    lastWanted = Key();   // may be an older post than asked for, ask again
+    return true;
+}
+
+//------------------------------------------------------------------------
+void CurveFeed::serve()
+{
+    if (!wanted.fetch())
+        return;
+    const Key& key = wanted.front();
+    post(CurveCache::acquire(key.threshold, key.knee, key.rs));
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
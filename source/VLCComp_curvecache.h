@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_gaincurve.h"
+
+#include <memory>
+#include <mutex>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  CurveCache
+//  Process-wide GainCurve tables, built once per threshold/knee/ratio and
+//  shared read-only by every instance in the module that asks for the
+//  same settings, so 500 instances on a handful of presets hold a handful
+//  of tables instead of 500 and keep them warm in a shared cache level.
+//  A table lives as long as someone holds its handle. The curve doesn't
+//  depend on the sample rate, so it isn't part of the key.
+//
+//  acquire() locks and may allocate, and dropping the last handle frees:
+//  neither belongs on the audio thread. The processors take handles in
+//  setState/setupProcessing and from CurveFeed's builder thread, and only
+//  pass raw pointers to process().
+//------------------------------------------------------------------------
+class CurveCache
+{
+public:
+    using Handle = std::shared_ptr<const GainCurve>;
+
+    static Handle acquire(double f_threshold, double f_knee, double f_rs);
+
+    /** Tables alive right now. */
+    static size_t size();
+};
+
+//------------------------------------------------------------------------
+//  CurveFeed
+//  One instance's tables on their way to its audio thread. The audio
+//  thread asks for the curve it runs on with want(), lock-free, and meanwhile
+//  evaluates it exactly (see CompressorCore::curveReady()); the module's
+//  builder thread, which every feed shares, takes the handle from
+//  CurveCache and hands it over, where fetch() picks it up. Other threads
+//  hand one over themselves with post(), a loaded state its table.
+//
+//  Handles the audio thread is done with are dropped by the next post(),
+//  off the audio thread like their acquire().
+//------------------------------------------------------------------------
+class CurveFeed
+{
+public:
+    CurveFeed();    // joins the builder, starting it with the first feed
+    ~CurveFeed();   // leaves it, after a build for this feed in flight
+    CurveFeed(const CurveFeed&) = delete;
+    CurveFeed& operator=(const CurveFeed&) = delete;
+
+    /** Any thread but the audio one. */
+    void post(CurveCache::Handle curve);
+
+    /** Audio thread: a table for these settings as soon as it's built.
+     *  Repeats are ignored until fetch() brings in a table. */
+    void want(double f_threshold, double f_knee, double f_rs);
+
+    /** Audio thread, or any while it isn't running: true if a table came
+     *  in since the last call, which front() then is. */
+    bool fetch();
+    const GainCurve* front() const { return toAudio.front().get(); }
+
+private:
+    struct Key
+    {
+        double threshold = 0.0, knee = -1.0, rs = 0.0;   // knee -1: none
+        bool operator==(const Key& k) const { return threshold == k.threshold && knee == k.knee && rs == k.rs; }
+    };
+    friend struct CurveBuilder;
+    void serve();   // builder thread
+
+    TripleBuffer<CurveCache::Handle> toAudio;
+    std::mutex                       postLock;   // post() from the builder and the host side
+    TripleBuffer<Key>                wanted;     // audio thread -> builder
+    Key                              lastWanted; // audio thread only
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
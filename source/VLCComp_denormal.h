@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VLCCOMP_DENORMAL_SSE 1
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#define VLCCOMP_DENORMAL_ARM64_MSVC 1
+#elif defined(__aarch64__)
+#define VLCCOMP_DENORMAL_ARM64 1
+#elif defined(__arm__) && defined(__ARM_FP)
+#define VLCCOMP_DENORMAL_ARM32 1
+#endif
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  DenormalGuard
+//  Flush-to-zero / denormals-are-zero for the lifetime of the object, the
+//  host's floating point mode is restored on destruction. Covers every
+//  recursion in the block (envelopes, gain smoothing, delay line, meters)
+//  instead of patching single variables.
+//  x86: MXCSR FTZ (bit 15) + DAZ (bit 6). ARM: FPCR/FPSCR FZ (bit 24),
+//  which flushes both inputs and results.
+//------------------------------------------------------------------------
+class DenormalGuard
+{
+public:
+    DenormalGuard ()
+    {
+#if VLCCOMP_DENORMAL_SSE
+        saved = _mm_getcsr ();
+        _mm_setcsr (static_cast<unsigned int> (saved) | 0x8040);
+#elif VLCCOMP_DENORMAL_ARM64_MSVC
+        saved = _ReadStatusReg (ARM64_FPCR);
+        _WriteStatusReg (ARM64_FPCR, saved | (1 << 24));
+#elif VLCCOMP_DENORMAL_ARM64
+        uint64_t fpcr;
+        __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (fpcr));
+        saved = fpcr;
+        __asm__ __volatile__ ("msr fpcr, %0" : : "r" (fpcr | (UINT64_C (1) << 24)));
+#elif VLCCOMP_DENORMAL_ARM32
+        uint32_t fpscr;
+        __asm__ __volatile__ ("vmrs %0, fpscr" : "=r" (fpscr));
+        saved = fpscr;
+        __asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (fpscr | (1u << 24)));
+#endif
+    }
+
+    ~DenormalGuard ()
+    {
+#if VLCCOMP_DENORMAL_SSE
+        _mm_setcsr (static_cast<unsigned int> (saved));
+#elif VLCCOMP_DENORMAL_ARM64_MSVC
+        _WriteStatusReg (ARM64_FPCR, static_cast<__int64> (saved));
+#elif VLCCOMP_DENORMAL_ARM64
+        __asm__ __volatile__ ("msr fpcr, %0" : : "r" (saved));
+#elif VLCCOMP_DENORMAL_ARM32
+        uint32_t fpscr = static_cast<uint32_t> (saved);
+        __asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (fpscr));
+#endif
+    }
+
+    DenormalGuard (const DenormalGuard&) = delete;
+    DenormalGuard& operator= (const DenormalGuard&) = delete;
+
+private:
+    uint64_t saved = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
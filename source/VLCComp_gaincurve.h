@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_shared.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  GainCurve
+//  Static transfer curve as a table of linear gain over the envelope,
+//  indexed in the log2 domain straight from the IEEE exponent and the top
+//  mantissa bits: kSteps nodes per octave, linear interpolation in between.
+//  Lookup is a couple of integer ops, two loads and one FMA.
+//
+//  Range is 2^kOctaveMin (-48 dB, below the lowest possible knee start of
+//  -40 dB, so gain is exactly 1 there) to 2^kOctaveMax (+36 dB), above
+//  which the analytic curve is used.
+//
+//  Error bound: linear interpolation of f over a step h is off by at most
+//  h^2/8 * max|f''|. In dB over the log envelope the curve is piecewise
+//  linear except the knee, where |g''| = rs / (2 knee) <= 0.5 /dB; a step
+//  is at most 20 log10(1 + 1/kSteps) = 0.135 dB, which bounds the knee
+//  error to 0.135^2 / 8 * 0.5 ~ 0.0011 dB. Interpolating linear gain
+//  against linear envelope adds the curvature of the exp/log mapping,
+//  about (rs * 0.135)^2 / 8 * ln(10)/20 < 0.0003 dB. Sweeping threshold,
+//  ratio and knee over their full ranges measures about 0.001 dB worst case.
+//------------------------------------------------------------------------
+class GainCurve
+{
+public:
+    static constexpr int kOctaveMin = -8;
+    static constexpr int kOctaveMax = 6;
+    static constexpr int kStepsLog2 = 6;
+    static constexpr int kSteps     = 1 << kStepsLog2;
+    static constexpr int kSize      = (kOctaveMax - kOctaveMin) * kSteps + 1;
+
+    static constexpr double kMinLevel = 1.0 / (1 << -kOctaveMin);
+    static constexpr double kMaxLevel = double(1 << kOctaveMax);
+
+    GainCurve() { nodeDb(); }   // shared node levels set up here, not in a first build()
+
+    /** Gain (dB) of the soft-knee curve for an envelope level in dB. */
+    static double curveDb(double f_env_db, double f_threshold, double f_knee, double f_rs)
+    {
+        if (f_env_db <= f_threshold - f_knee)
+        {
+            /* Gain below the knee (and below the threshold) */
+            return 0.0;
+        }
+        else if (f_env_db < f_threshold + f_knee)
+        {
+            /* Gain within the knee */
+            const double f_x = -( f_threshold - f_knee - f_env_db ) / f_knee;
+            return -f_knee * f_rs * f_x * f_x * 0.25;
+        }
+        /* Gain above the knee (and above the threshold) */
+        return ( f_threshold - f_env_db ) * f_rs;
+    }
+
+    bool matches(double f_threshold, double f_knee, double f_rs) const
+    {
+        return threshold == f_threshold && knee == f_knee && rs == f_rs;
+    }
+
+    /** The node levels in dB are the same for every curve, so a build is
+     *  an exp per node that isn't at unity gain, some 5-10 us. */
+    void build(double f_threshold, double f_knee, double f_rs)
+    {
+        threshold = f_threshold;
+        knee      = f_knee;
+        rs        = f_rs;
+
+        const double* db = nodeDb();
+        for (int i = 0; i < kSize; i++)
+        {
+            const double gain = curveDb(db[i], threshold, knee, rs);
+            table[i] = gain == 0.0 ? DspSample(1.0) : static_cast<DspSample>(std::exp(gain * kDbToLog));
+        }
+    }
+
+    /** Linear gain for a linear envelope level. */
+    DspSample process(DspSample f_env) const
+    {
+        const double env = f_env;
+        if (!(env >= kMinLevel))   // also catches NaN
+            return DspSample(1.0);
+        if (env >= kMaxLevel)
+            return static_cast<DspSample>(std::pow(10.0, curveDb(20.0 * std::log10(env), threshold, knee, rs) / 20.0));
+
+        uint64_t bits;
+        std::memcpy(&bits, &env, sizeof(bits));
+        const int      octave = static_cast<int>(bits >> 52) - 1023;
+        const uint64_t mant   = bits & kMantMask;
+        const uint32_t index  = static_cast<uint32_t>((octave - kOctaveMin) * kSteps + static_cast<int>(mant >> kFracBits));
+        const DspSample frac  = static_cast<DspSample>(static_cast<double>(mant & kFracMask) * kFracScale);
+
+        const DspSample a = table[index];
+        return a + frac * (table[index + 1] - a);
+    }
+
+    /** The same from curveDb() itself, no table: exact, at a log10 and a
+     *  pow a call. For offline renders, and for curves the table hasn't
+     *  caught up with yet. */
+    static DspSample processExact(DspSample f_env, double f_threshold, double f_knee, double f_rs)
+    {
+        const double env = f_env;
+        if (!(env >= kMinLevel))   // 0 dB that far below any knee, also catches NaN
+            return DspSample(1.0);
+        return static_cast<DspSample>(std::pow(10.0, curveDb(20.0 * std::log10(env), f_threshold, f_knee, f_rs) / 20.0));
+    }
+
+    /** The kSize nodes, for vectorized lookups doing what process() does. */
+    const DspSample* getTable() const { return table; }
+
+private:
+    static constexpr int      kFracBits  = 52 - kStepsLog2;
+    static constexpr uint64_t kMantMask  = (uint64_t(1) << 52) - 1;
+    static constexpr uint64_t kFracMask  = (uint64_t(1) << kFracBits) - 1;
+    static constexpr double   kFracScale = 1.0 / double(uint64_t(1) << kFracBits);
+    static constexpr double   kDbToLog   = 0.11512925464970228;    // ln(10) / 20
+
+    // Envelope of every node, in dB
+    static const double* nodeDb()
+    {
+        struct Nodes
+        {
+            double db[kSize];
+            Nodes()
+            {
+                for (int i = 0; i < kSize; i++)
+                    db[i] = 20.0 * std::log10(std::ldexp(1.0 + double(i % kSteps) / kSteps, kOctaveMin + i / kSteps));
+            }
+        };
+        static const Nodes nodes;
+        return nodes.db;
+    }
+
+    DspSample table[kSize] = {0.0, };
+    double threshold = 0.0;
+    double knee      = -1.0; // never matches a real knee before the first build
+    double rs        = 0.0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
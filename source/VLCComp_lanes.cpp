@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_lanes_kernel.h"
+
+#if VLCCOMP_LANES_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// Plain scalar, for CPUs without any of the vector engines
+//------------------------------------------------------------------------
+struct ScalarLanes
+{
+    using R = DspSample;
+    using M = bool;
+    static constexpr int32 W = 1;
+
+    static R    load(const DspSample* p) { return *p; }
+    static void store(DspSample* p, R a) { *p = a; }
+    static R    set1(DspSample x) { return x; }
+    static R    zero() { return DspSample(0.0); }
+    static R    add(R a, R b) { return a + b; }
+    static R    sub(R a, R b) { return a - b; }
+    static R    mul(R a, R b) { return a * b; }
+    static R    div(R a, R b) { return a / b; }
+    static R    sqrt(R a) { return std::sqrt(a); }
+    static R    abs(R a) { return std::abs(a); }
+    static M    gt(R a, R b) { return a > b; }
+    static M    lt(R a, R b) { return a < b; }
+    static M    isnan(R a) { return a != a; }
+    static R    select(M m, R a, R b) { return m ? a : b; }
+    static R    curve(const GainCurve& g, R env) { return g.process(env); }
+};
+
+void runScalarLanes(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+                    const DspSample* in, DspSample* out, int32 frames)
+{
+    runLanes<LanePair<ScalarLanes>>(c, s, cursor, in, out, frames);
+}
+
+const LaneEngine laneEngineScalar = {"scalar", LanePair<ScalarLanes>::W, runScalarLanes};
+
+//------------------------------------------------------------------------
+// What the CPU and the OS support: AVX state needs OS saving (XCR0)
+//------------------------------------------------------------------------
+#if VLCCOMP_LANES_X86
+#if defined(_MSC_VER)
+bool cpuHas(int leaf, int reg, int bit)
+{
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < leaf)
+        return false;
+    __cpuidex(r, leaf, 0);
+    return (r[reg] >> bit) & 1;
+}
+
+bool osSaves(unsigned long long mask)
+{
+    if (!cpuHas(1, 2, 27)) // OSXSAVE
+        return false;
+    return (_xgetbv(0) & mask) == mask;
+}
+
+bool hasAvx2()   { return osSaves(0x06) && cpuHas(7, 1, 5); }
+bool hasAvx512() { return osSaves(0xE6) && cpuHas(7, 1, 16); }
+#else
+bool hasAvx2()   { return __builtin_cpu_supports("avx2"); }
+bool hasAvx512() { return __builtin_cpu_supports("avx512f"); }
+#endif
+#endif
+} // namespace
+
+//------------------------------------------------------------------------
+void laneCurveGains(const GainCurve& curve, const DspSample* env, DspSample* gain, int32 width)
+{
+    for (int32 lane = 0; lane < width; lane++)
+        gain[lane] = curve.process(env[lane]);
+}
+
+//------------------------------------------------------------------------
+// LaneCompressor
+//------------------------------------------------------------------------
+const LaneEngine& LaneCompressor::selectEngine(int32 maxWidth)
+{
+    const auto fits = [maxWidth](const LaneEngine& e) { return maxWidth <= 0 || e.width <= maxWidth; };
+#if VLCCOMP_LANES_X86
+    static const bool avx512 = hasAvx512();
+    static const bool avx2   = hasAvx2();
+    if (avx512 && fits(laneEngineAvx512))
+        return laneEngineAvx512;
+    if (avx2 && fits(laneEngineAvx2))
+        return laneEngineAvx2;
+    if (fits(laneEngineSse2)) // x86-64 baseline
+        return laneEngineSse2;
+#endif
+    (void)fits;
+    return laneEngineScalar;
+}
+
+//------------------------------------------------------------------------
+std::vector<const LaneEngine*> LaneCompressor::availableEngines()
+{
+    const LaneEngine* widest = &selectEngine();
+    std::vector<const LaneEngine*> engines;
+    for (int32 maxWidth = 1; engines.empty() || engines.back() != widest; maxWidth *= 2)
+    {
+        const LaneEngine* engine = &selectEngine(maxWidth);
+        if (engines.empty() || engines.back() != engine)
+            engines.push_back(engine);
+    }
+    return engines;
+}
+
+//------------------------------------------------------------------------
+bool LaneCompressor::setup(SampleRate SR, int32 streams, int32 maxWidth)
+{
+    release();
+    if (streams <= 0)
+        return true;
+
+    engine = &selectEngine(maxWidth);
+    const int32 W = engine->width;
+
+    /* Same RMS and lookahead sizes as CompressorCore::setup() at full rate */
+    const ParamValue f_num = 0.01 * SR;
+    cursor          = LaneCursor();
+    cursor.rmsCount = CompressorCore::Round( CompressorCore::Clamp( 0.5 * f_num, 1.0, RMS_BUF_SIZE ) );
+    cursor.laCount  = CompressorCore::Round( CompressorCore::Clamp( f_num, 1.0, LOOKAHEAD_SIZE ) );
+
+    /* Groups back to back, each one's vectors contiguous */
+    groupSize  = size_t(kLaneHotCount + cursor.rmsCount + 2 * cursor.laCount) * W;
+    numStreams = streams;
+    numGroups  = (streams + W - 1) / W;
+
+    const size_t poolBytes = AlignedPool::footprint<DspSample>(groupSize * numGroups)
+                           + 2 * AlignedPool::footprint<DspSample>(size_t(kChunk) * W);
+    if (!pool.reserve(poolBytes))
+    {
+        release();
+        return false;
+    }
+    groups  = pool.take<DspSample>(groupSize * numGroups);
+    packIn  = pool.take<DspSample>(size_t(kChunk) * W);
+    packOut = pool.take<DspSample>(size_t(kChunk) * W);
+    reset();
+    return true;
+}
+
+//------------------------------------------------------------------------
+void LaneCompressor::release()
+{
+    pool.release();
+    engine     = nullptr;
+    numStreams = 0;
+    numGroups  = 0;
+    groupSize  = 0;
+    groups = packIn = packOut = nullptr;
+}
+
+//------------------------------------------------------------------------
+void LaneCompressor::reset()
+{
+    if (!isReady())
+        return;
+
+    std::fill(groups, groups + groupSize * numGroups, DspSample(0.0));
+    for (int32 group = 0; group < numGroups; group++)
+    {
+        const LaneState s = stateOf(group);
+        std::fill(s.hot + kLaneGain * engine->width,    s.hot + (kLaneGain + 1) * engine->width,    DspSample(1.0));
+        std::fill(s.hot + kLaneGainOut * engine->width, s.hot + (kLaneGainOut + 1) * engine->width, DspSample(1.0));
+    }
+    cursor.count  = 0;
+    cursor.rmsPos = 0;
+    cursor.laPos  = 0;
+}
+
+//------------------------------------------------------------------------
+LaneState LaneCompressor::stateOf(int32 group) const
+{
+    const int32 W = engine->width;
+    LaneState s;
+    s.hot   = groups + groupSize * group;
+    s.rms   = s.hot + kLaneHotCount * W;
+    s.levIn = s.rms + size_t(cursor.rmsCount) * W;
+    s.vals  = s.levIn + size_t(cursor.laCount) * W;
+    return s;
+}
+
+//------------------------------------------------------------------------
+DspSample LaneCompressor::getGain(int32 stream) const
+{
+    if (!isReady() || stream < 0 || stream >= numStreams)
+        return DspSample(1.0);
+    const int32 W = engine->width;
+    return stateOf(stream / W).hot[kLaneGain * W + stream % W];
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,196 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_core.h"
+#include "VLCComp_denormal.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  Lane kernel interface
+//  A group is W independent mono streams packed into the lanes of one
+//  SIMD register: all state and audio is lane interleaved, [i * W + lane].
+//  The recursions can't be vectorized across time, across streams they
+//  can, so one instruction sequence runs the detector, gain smoothing and
+//  delay line of W streams at once. Groups advance in lockstep, the
+//  positions are shared.
+//------------------------------------------------------------------------
+enum LaneHot
+{
+    kLaneSum,       // running sum of squares, 4 samples
+    kLaneAmp,       // RMS of the window
+    kLaneGain,
+    kLaneGainOut,
+    kLaneEnv,
+    kLaneEnvRms,
+    kLaneEnvPeak,
+    kLaneRmsSum,    // sum over the RMS window
+    kLaneHotCount
+};
+
+struct LaneState
+{
+    DspSample* hot   = nullptr;   // kLaneHotCount vectors
+    DspSample* rms   = nullptr;   // rmsCount vectors, mean squares
+    DspSample* levIn = nullptr;   // laCount vectors, peak levels
+    DspSample* vals  = nullptr;   // laCount vectors, delayed audio
+};
+
+struct LaneCursor
+{
+    uint32 count    = 0;          // samples, the gain computer steps every 4
+    uint32 rmsPos   = 0;
+    uint32 rmsCount = 0;
+    uint32 laPos    = 0;
+    uint32 laCount  = 0;
+};
+
+struct LaneCoefs
+{
+    DspSample inputGain, rmsPeak, ga, gr, efA, outputGain, mug, mix;
+    bool      softBypass;
+    const GainCurve* curve;
+};
+
+/** Runs one group over frames packed samples, in and out [frame * W + lane]. */
+using LaneKernel = void (*)(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+                            const DspSample* in, DspSample* out, int32 frames);
+
+struct LaneEngine
+{
+    const char* name;
+    int32       width;            // streams per group
+    LaneKernel  run;
+};
+
+/** The static curve over width envelopes, out of line so that the ISA
+ *  specific kernels never instantiate shared inline code. */
+void laneCurveGains(const GainCurve& curve, const DspSample* env, DspSample* gain, int32 width);
+
+//------------------------------------------------------------------------
+//  LaneCompressor
+//  Many independent mono streams with identical settings, e.g. the voice
+//  channels of a conferencing server, compressed W at a time in SIMD lanes
+//  (SSE2, AVX2 or AVX-512, picked at runtime from what the CPU has). A
+//  group is two registers: W is 4/8/16 streams in the double engine,
+//  8/16/32 with VLCCOMP_FLOAT_ENGINE. Each stream's output is bit
+//  identical to a mono CompressorCore with the classic detector below
+//  88.2 kHz; the anticipating one (pAnticipate) is not in the lanes and
+//  is ignored, nor is sidechain decimation, they always run at full rate.
+//------------------------------------------------------------------------
+class LaneCompressor
+{
+public:
+    using SampleRate = Steinberg::Vst::SampleRate;
+
+    /** Widest engine this CPU runs, capped to maxWidth streams if > 0. */
+    static const LaneEngine& selectEngine(int32 maxWidth = 0);
+
+    /** Every engine selectEngine() can pick on this CPU, narrowest first,
+     *  for the tools that compare or time them. */
+    static std::vector<const LaneEngine*> availableEngines();
+
+    /** Sizes everything for numStreams at this rate, maxWidth as in
+     *  selectEngine(). Not realtime safe. */
+    bool setup(SampleRate SR, int32 numStreams, int32 maxWidth = 0);
+    void release();
+    void reset();
+
+    bool isReady() const { return numGroups > 0; }
+    int32 getStreams() const { return numStreams; }
+    int32 getWidth() const { return engine ? engine->width : 0; }
+    const char* getEngineName() const { return engine ? engine->name : "none"; }
+    size_t footprint() const { return pool.capacity(); }
+
+    DspSample getGain(int32 stream) const;   // smoothed gain, linear
+
+    void updateCurve(const CompParams& params)
+    {
+        if (!curve.matches(params.f_threshold, params.f_knee, params.f_rs))
+            curve.build(params.f_threshold, params.f_knee, params.f_rs);
+    }
+
+    /** Compresses inputs[stream] into outputs[stream] for all getStreams()
+     *  streams; in place is fine. */
+    template <typename SampleType>
+    void process(SampleType** inputs, SampleType** outputs, int32 sampleFrames, const CompParams& params);
+
+private:
+    static constexpr int32 kChunk = 256;    // frames packed at a time
+
+    const LaneEngine* engine = nullptr;
+    GainCurve  curve;
+    LaneCursor cursor;
+    int32      numStreams = 0;
+    int32      numGroups  = 0;
+    size_t     groupSize  = 0;              // DspSamples per group state
+
+    DspSample*  groups = nullptr;           // numGroups x groupSize
+    DspSample*  packIn  = nullptr;          // kChunk x W
+    DspSample*  packOut = nullptr;
+    AlignedPool pool;
+
+    LaneState stateOf(int32 group) const;
+};
+
+//------------------------------------------------------------------------
+template <typename SampleType>
+void LaneCompressor::process(SampleType** inputs, SampleType** outputs, int32 sampleFrames, const CompParams& params)
+{
+    if (!isReady())
+        return;
+
+    DenormalGuard denormalGuard;
+    const LaneCoefs c = {
+        static_cast<DspSample>(params.inputGain),
+        static_cast<DspSample>(params.pRMS_PEAK),
+        static_cast<DspSample>(params.f_ga),
+        static_cast<DspSample>(params.f_gr),
+        static_cast<DspSample>(params.f_ef_a),
+        static_cast<DspSample>(params.outputGain),
+        static_cast<DspSample>(params.f_mug),
+        static_cast<DspSample>(params.pMix),
+        params.pSoftBypass,
+        &curve
+    };
+    const int32 W = engine->width;
+
+    LaneCursor next = cursor;
+    for (int32 group = 0; group < numGroups; group++)
+    {
+        const LaneState s     = stateOf(group);
+        const int32     first = group * W;
+        const int32     lanes = std::min(W, numStreams - first);   // the rest run silence
+
+        LaneCursor at = cursor;
+        for (int32 done = 0; done < sampleFrames; done += kChunk)
+        {
+            const int32 n = std::min(kChunk, sampleFrames - done);
+            for (int32 lane = 0; lane < W; lane++)
+            {
+                const SampleType* in = lane < lanes ? inputs[first + lane] + done : nullptr;
+                for (int32 i = 0; i < n; i++)
+                    packIn[i * W + lane] = in ? static_cast<DspSample>(in[i]) : DspSample(0.0);
+            }
+
+            engine->run(c, s, at, packIn, packOut, n);
+
+            for (int32 lane = 0; lane < lanes; lane++)
+            {
+                SampleType* out = outputs[first + lane] + done;
+                for (int32 i = 0; i < n; i++)
+                    out[i] = static_cast<SampleType>(packOut[i * W + lane]);
+            }
+        }
+        next = at;
+    }
+    cursor = next;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
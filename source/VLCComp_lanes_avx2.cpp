@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_lanes_kernel.h"
+
+#if VLCCOMP_LANES_X86
+#include <immintrin.h>
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// AVX2: 4 doubles or 8 floats, this file is built with -mavx2
+//------------------------------------------------------------------------
+#if VLCCOMP_FLOAT_ENGINE
+struct Avx2Lanes
+{
+    using R = __m256;
+    using M = __m256;
+    static constexpr int32 W = 8;
+
+    static R    load(const float* p) { return _mm256_load_ps(p); }
+    static void store(float* p, R a) { _mm256_store_ps(p, a); }
+    static R    set1(float x) { return _mm256_set1_ps(x); }
+    static R    zero() { return _mm256_setzero_ps(); }
+    static R    add(R a, R b) { return _mm256_add_ps(a, b); }
+    static R    sub(R a, R b) { return _mm256_sub_ps(a, b); }
+    static R    mul(R a, R b) { return _mm256_mul_ps(a, b); }
+    static R    div(R a, R b) { return _mm256_div_ps(a, b); }
+    static R    sqrt(R a) { return _mm256_sqrt_ps(a); }
+    static R    abs(R a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static M    gt(R a, R b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static M    lt(R a, R b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static M    isnan(R a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    static R    select(M m, R a, R b) { return _mm256_blendv_ps(b, a, m); }
+
+    static R curve(const GainCurve& g, R env)
+    {
+        const R hi = _mm256_set1_ps(float(GainCurve::kMaxLevel));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(env, hi, _CMP_GE_OQ)))
+            return laneCurveFallback<Avx2Lanes>(g, env);
+
+        const R       lo      = _mm256_set1_ps(float(GainCurve::kMinLevel));
+        const R       inRange = _mm256_cmp_ps(env, lo, _CMP_GE_OQ);   // false for NaN too
+        const __m256i bits    = _mm256_castps_si256(_mm256_blendv_ps(lo, env, inRange));
+        const __m256i index   = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23 - GainCurve::kStepsLog2),
+                                                 _mm256_set1_epi32((127 + GainCurve::kOctaveMin) * GainCurve::kSteps));
+        const __m256i mant    = _mm256_and_si256(bits, _mm256_set1_epi32((1 << (23 - GainCurve::kStepsLog2)) - 1));
+        const R       frac    = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_slli_epi32(mant, GainCurve::kStepsLog2),
+                                                                                _mm256_set1_epi32(0x3F800000))),
+                                              _mm256_set1_ps(1.0f));
+        const R a = _mm256_i32gather_ps(g.getTable(), index, 4);
+        const R b = _mm256_i32gather_ps(g.getTable() + 1, index, 4);
+        return _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(a, _mm256_mul_ps(frac, _mm256_sub_ps(b, a))), inRange);
+    }
+};
+#else
+struct Avx2Lanes
+{
+    using R = __m256d;
+    using M = __m256d;
+    static constexpr int32 W = 4;
+
+    static R    load(const double* p) { return _mm256_load_pd(p); }
+    static void store(double* p, R a) { _mm256_store_pd(p, a); }
+    static R    set1(double x) { return _mm256_set1_pd(x); }
+    static R    zero() { return _mm256_setzero_pd(); }
+    static R    add(R a, R b) { return _mm256_add_pd(a, b); }
+    static R    sub(R a, R b) { return _mm256_sub_pd(a, b); }
+    static R    mul(R a, R b) { return _mm256_mul_pd(a, b); }
+    static R    div(R a, R b) { return _mm256_div_pd(a, b); }
+    static R    sqrt(R a) { return _mm256_sqrt_pd(a); }
+    static R    abs(R a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static M    gt(R a, R b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static M    lt(R a, R b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static M    isnan(R a) { return _mm256_cmp_pd(a, a, _CMP_UNORD_Q); }
+    static R    select(M m, R a, R b) { return _mm256_blendv_pd(b, a, m); }
+
+    static R curve(const GainCurve& g, R env)
+    {
+        const R hi = _mm256_set1_pd(GainCurve::kMaxLevel);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(env, hi, _CMP_GE_OQ)))
+            return laneCurveFallback<Avx2Lanes>(g, env);
+
+        const R       lo      = _mm256_set1_pd(GainCurve::kMinLevel);
+        const R       inRange = _mm256_cmp_pd(env, lo, _CMP_GE_OQ);   // false for NaN too
+        const __m256i bits    = _mm256_castpd_si256(_mm256_blendv_pd(lo, env, inRange));
+        const __m256i index   = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52 - GainCurve::kStepsLog2),
+                                                 _mm256_set1_epi64x((1023 + GainCurve::kOctaveMin) * GainCurve::kSteps));
+        const __m256i mant    = _mm256_and_si256(bits, _mm256_set1_epi64x((1ll << (52 - GainCurve::kStepsLog2)) - 1));
+        const R       frac    = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_slli_epi64(mant, GainCurve::kStepsLog2),
+                                                                                _mm256_set1_epi64x(0x3FF0000000000000ll))),
+                                              _mm256_set1_pd(1.0));
+        const R a = _mm256_i64gather_pd(g.getTable(), index, 8);
+        const R b = _mm256_i64gather_pd(g.getTable() + 1, index, 8);
+        return _mm256_blendv_pd(_mm256_set1_pd(1.0), _mm256_add_pd(a, _mm256_mul_pd(frac, _mm256_sub_pd(b, a))), inRange);
+    }
+};
+#endif
+
+void runAvx2Lanes(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+                  const DspSample* in, DspSample* out, int32 frames)
+{
+    runLanes<LanePair<Avx2Lanes>>(c, s, cursor, in, out, frames);
+}
+} // namespace
+
+const LaneEngine laneEngineAvx2 = {"avx2", LanePair<Avx2Lanes>::W, runAvx2Lanes};
+
+//------------------------------------------------------------------------
+} // namespace yg331
+#endif
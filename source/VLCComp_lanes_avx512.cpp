@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_lanes_kernel.h"
+
+#if VLCCOMP_LANES_X86
+#include <immintrin.h>
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// AVX-512F: 8 doubles or 16 floats, this file is built with -mavx512f.
+// Compares go to mask registers, selects are masked blends.
+//------------------------------------------------------------------------
+#if VLCCOMP_FLOAT_ENGINE
+struct Avx512Lanes
+{
+    using R = __m512;
+    using M = __mmask16;
+    static constexpr int32 W = 16;
+
+    static R    load(const float* p) { return _mm512_load_ps(p); }
+    static void store(float* p, R a) { _mm512_store_ps(p, a); }
+    static R    set1(float x) { return _mm512_set1_ps(x); }
+    static R    zero() { return _mm512_setzero_ps(); }
+    static R    add(R a, R b) { return _mm512_add_ps(a, b); }
+    static R    sub(R a, R b) { return _mm512_sub_ps(a, b); }
+    static R    mul(R a, R b) { return _mm512_mul_ps(a, b); }
+    static R    div(R a, R b) { return _mm512_div_ps(a, b); }
+    static R    sqrt(R a) { return _mm512_sqrt_ps(a); }
+    static R    abs(R a) { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7FFFFFFF))); }
+    static M    gt(R a, R b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static M    lt(R a, R b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static M    isnan(R a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+    static R    select(M m, R a, R b) { return _mm512_mask_blend_ps(m, b, a); }
+
+    static R curve(const GainCurve& g, R env)
+    {
+        const R hi = _mm512_set1_ps(float(GainCurve::kMaxLevel));
+        if (_mm512_cmp_ps_mask(env, hi, _CMP_GE_OQ))
+            return laneCurveFallback<Avx512Lanes>(g, env);
+
+        const R       lo      = _mm512_set1_ps(float(GainCurve::kMinLevel));
+        const M       inRange = _mm512_cmp_ps_mask(env, lo, _CMP_GE_OQ);   // false for NaN too
+        const __m512i bits    = _mm512_castps_si512(_mm512_mask_blend_ps(inRange, lo, env));
+        const __m512i index   = _mm512_sub_epi32(_mm512_srli_epi32(bits, 23 - GainCurve::kStepsLog2),
+                                                 _mm512_set1_epi32((127 + GainCurve::kOctaveMin) * GainCurve::kSteps));
+        const __m512i mant    = _mm512_and_si512(bits, _mm512_set1_epi32((1 << (23 - GainCurve::kStepsLog2)) - 1));
+        const R       frac    = _mm512_sub_ps(_mm512_castsi512_ps(_mm512_or_si512(_mm512_slli_epi32(mant, GainCurve::kStepsLog2),
+                                                                                _mm512_set1_epi32(0x3F800000))),
+                                              _mm512_set1_ps(1.0f));
+        const R a = _mm512_i32gather_ps(index, g.getTable(), 4);
+        const R b = _mm512_i32gather_ps(index, g.getTable() + 1, 4);
+        return _mm512_mask_blend_ps(inRange, _mm512_set1_ps(1.0f), _mm512_add_ps(a, _mm512_mul_ps(frac, _mm512_sub_ps(b, a))));
+    }
+};
+#else
+struct Avx512Lanes
+{
+    using R = __m512d;
+    using M = __mmask8;
+    static constexpr int32 W = 8;
+
+    static R    load(const double* p) { return _mm512_load_pd(p); }
+    static void store(double* p, R a) { _mm512_store_pd(p, a); }
+    static R    set1(double x) { return _mm512_set1_pd(x); }
+    static R    zero() { return _mm512_setzero_pd(); }
+    static R    add(R a, R b) { return _mm512_add_pd(a, b); }
+    static R    sub(R a, R b) { return _mm512_sub_pd(a, b); }
+    static R    mul(R a, R b) { return _mm512_mul_pd(a, b); }
+    static R    div(R a, R b) { return _mm512_div_pd(a, b); }
+    static R    sqrt(R a) { return _mm512_sqrt_pd(a); }
+    static R    abs(R a) { return _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(a), _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFll))); }
+    static M    gt(R a, R b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static M    lt(R a, R b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static M    isnan(R a) { return _mm512_cmp_pd_mask(a, a, _CMP_UNORD_Q); }
+    static R    select(M m, R a, R b) { return _mm512_mask_blend_pd(m, b, a); }
+
+    static R curve(const GainCurve& g, R env)
+    {
+        const R hi = _mm512_set1_pd(GainCurve::kMaxLevel);
+        if (_mm512_cmp_pd_mask(env, hi, _CMP_GE_OQ))
+            return laneCurveFallback<Avx512Lanes>(g, env);
+
+        const R       lo      = _mm512_set1_pd(GainCurve::kMinLevel);
+        const M       inRange = _mm512_cmp_pd_mask(env, lo, _CMP_GE_OQ);   // false for NaN too
+        const __m512i bits    = _mm512_castpd_si512(_mm512_mask_blend_pd(inRange, lo, env));
+        const __m512i index   = _mm512_sub_epi64(_mm512_srli_epi64(bits, 52 - GainCurve::kStepsLog2),
+                                                 _mm512_set1_epi64((1023 + GainCurve::kOctaveMin) * GainCurve::kSteps));
+        const __m512i mant    = _mm512_and_si512(bits, _mm512_set1_epi64((1ll << (52 - GainCurve::kStepsLog2)) - 1));
+        const R       frac    = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_slli_epi64(mant, GainCurve::kStepsLog2),
+                                                                                _mm512_set1_epi64(0x3FF0000000000000ll))),
+                                              _mm512_set1_pd(1.0));
+        const R a = _mm512_i64gather_pd(index, g.getTable(), 8);
+        const R b = _mm512_i64gather_pd(index, g.getTable() + 1, 8);
+        return _mm512_mask_blend_pd(inRange, _mm512_set1_pd(1.0), _mm512_add_pd(a, _mm512_mul_pd(frac, _mm512_sub_pd(b, a))));
+    }
+};
+#endif
+
+void runAvx512Lanes(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+                    const DspSample* in, DspSample* out, int32 frames)
+{
+    runLanes<LanePair<Avx512Lanes>>(c, s, cursor, in, out, frames);
+}
+} // namespace
+
+const LaneEngine laneEngineAvx512 = {"avx512", LanePair<Avx512Lanes>::W, runAvx512Lanes};
+
+//------------------------------------------------------------------------
+} // namespace yg331
+#endif
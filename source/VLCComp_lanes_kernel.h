@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_lanes.h"
+
+#if defined(__x86_64__) || defined(_M_X64)   // SSE2 is baseline there
+#define VLCCOMP_LANES_X86 1
+#endif
+
+namespace yg331 {
+#if VLCCOMP_LANES_X86
+// one translation unit each, built with that instruction set enabled
+extern const LaneEngine laneEngineSse2;
+extern const LaneEngine laneEngineAvx2;
+extern const LaneEngine laneEngineAvx512;
+#endif
+
+//------------------------------------------------------------------------
+//  runLanes
+//  CompressorCore::process() for one group of V::W mono streams, written
+//  once against a small vector type V and compiled per instruction set:
+//    R           register of W DspSamples, M the mask compares produce
+//    load/store  aligned, set1, add/sub/mul/div, sqrt, abs
+//    gt/lt/isnan(a)  masks, select(m, a, b) = m ? a : b per lane
+//    curve(g, env)   g.process() per lane
+//  Every step is the scalar one in the same order, branches turned into
+//  selects, so each lane rounds exactly like the mono core. Built with
+//  floating point contraction off: an FMA would round differently.
+//  Only V's intrinsics and laneCurveGains() are called from here, no
+//  shared inline code gets compiled for an instruction set the CPU may
+//  not have.
+//
+//  V::curve() of the gather capable sets indexes GainCurve's table the
+//  way process() does: the envelope's bits shifted right give exponent
+//  and top mantissa bits, i.e. the node, and the remaining mantissa bits
+//  moved under the exponent of 1.0 give 1 + frac, exactly. Lanes above
+//  the table (+36 dB) fall back to laneCurveGains().
+//------------------------------------------------------------------------
+template <typename V>
+void runLanes(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+              const DspSample* in, DspSample* out, int32 frames)
+{
+    using R = typename V::R;
+    constexpr int32 W = V::W;
+
+    const R inputGain  = V::set1(c.inputGain);
+    const R rmsPeak    = V::set1(c.rmsPeak);
+    const R ga         = V::set1(c.ga);
+    const R gr         = V::set1(c.gr);
+    const R oneGa      = V::set1(DspSample(1.0) - c.ga);
+    const R oneGr      = V::set1(DspSample(1.0) - c.gr);
+    const R efA        = V::set1(c.efA);
+    const R oneEfA     = V::set1(DspSample(1.0) - c.efA);
+    const R mug        = V::set1(c.mug);
+    const R mix        = V::set1(c.mix);
+    const R oneMix     = V::set1(DspSample(1.0) - c.mix);
+    const R outputGain = V::set1(c.outputGain);
+    const R quarter    = V::set1(DspSample(0.25));
+    const R floor      = V::set1(DspSample(1.0e-6f));
+    const R rmsCount   = V::set1(static_cast<DspSample>(cursor.rmsCount));
+    const R zero       = V::zero();
+
+    R f_sum      = V::load(s.hot + kLaneSum * W);
+    R f_amp      = V::load(s.hot + kLaneAmp * W);
+    R f_gain     = V::load(s.hot + kLaneGain * W);
+    R f_gain_out = V::load(s.hot + kLaneGainOut * W);
+    R f_env      = V::load(s.hot + kLaneEnv * W);
+    R f_env_rms  = V::load(s.hot + kLaneEnvRms * W);
+    R f_env_peak = V::load(s.hot + kLaneEnvPeak * W);
+    R rms_sum    = V::load(s.hot + kLaneRmsSum * W);
+
+    uint32 i_count = cursor.count;
+    uint32 rms_pos = cursor.rmsPos;
+    uint32 la_pos  = cursor.laPos;
+
+    for (int32 i = 0; i < frames; i++)
+    {
+        const R f_x = V::load(in + i * W);
+
+        /* Peak level, one channel per stream */
+        const R f_lev_in_new = V::abs(V::mul(f_x, inputGain));
+        const R f_lev_in_old = V::load(s.levIn + la_pos * W);
+        V::store(s.levIn + la_pos * W, f_lev_in_new);
+
+        f_sum = V::add(f_sum, V::mul(f_lev_in_new, f_lev_in_new));
+
+        /* RMS and peak envelopes, attack where the level is above */
+        const auto rmsUp = V::gt(f_amp, f_env_rms);
+        f_env_rms = V::add(V::mul(f_env_rms, V::select(rmsUp, ga, gr)), V::mul(f_amp, V::select(rmsUp, oneGa, oneGr)));
+
+        const auto peakUp = V::gt(f_lev_in_old, f_env_peak);
+        f_env_peak = V::add(V::mul(f_env_peak, V::select(peakUp, ga, gr)), V::mul(f_lev_in_old, V::select(peakUp, oneGa, oneGr)));
+
+        /* Every 4 samples: RMS window, superposition and the static curve */
+        if ((i_count++ & 3) == 3)
+        {
+            const R f_ms = V::mul(f_sum, quarter);
+            rms_sum = V::sub(rms_sum, V::load(s.rms + rms_pos * W));
+            rms_sum = V::add(rms_sum, f_ms);
+            rms_sum = V::select(V::lt(rms_sum, floor), zero, rms_sum);
+            V::store(s.rms + rms_pos * W, f_ms);
+            if (++rms_pos == cursor.rmsCount) rms_pos = 0;
+            f_amp   = V::sqrt(V::div(rms_sum, rmsCount));
+            f_sum   = zero;
+
+            f_env_rms = V::select(V::isnan(f_env_rms), zero, f_env_rms);
+            f_env     = V::add(f_env_rms, V::mul(rmsPeak, V::sub(f_env_peak, f_env_rms)));
+
+            f_gain_out = V::curve(*c.curve, f_env);
+        }
+
+        f_gain = V::add(V::mul(f_gain, efA), V::mul(f_gain_out, oneEfA));
+
+        /* Output the compressed delayed value, store the current one */
+        const R f_d = V::load(s.vals + la_pos * W);
+        R f_y = V::mul(V::mul(V::mul(f_d, f_gain), mug), inputGain);
+        f_y = V::add(V::mul(f_y, mix), V::mul(f_d, oneMix));
+        f_y = V::mul(f_y, outputGain);
+        V::store(out + i * W, c.softBypass ? f_d : f_y);
+        V::store(s.vals + la_pos * W, f_x);
+
+        if (++la_pos == cursor.laCount) la_pos = 0;
+    }
+
+    V::store(s.hot + kLaneSum * W,     f_sum);
+    V::store(s.hot + kLaneAmp * W,     f_amp);
+    V::store(s.hot + kLaneGain * W,    f_gain);
+    V::store(s.hot + kLaneGainOut * W, f_gain_out);
+    V::store(s.hot + kLaneEnv * W,     f_env);
+    V::store(s.hot + kLaneEnvRms * W,  f_env_rms);
+    V::store(s.hot + kLaneEnvPeak * W, f_env_peak);
+    V::store(s.hot + kLaneRmsSum * W,  rms_sum);
+
+    cursor.count  = i_count;
+    cursor.rmsPos = rms_pos;
+    cursor.laPos  = la_pos;
+}
+
+//------------------------------------------------------------------------
+//  LanePair
+//  Two registers of V as one: every recursion is a latency bound chain,
+//  interleaving two independent ones keeps the pipeline full, which pays
+//  about as much again as the SIMD width itself.
+//------------------------------------------------------------------------
+template <typename V>
+struct LanePair
+{
+    struct R { typename V::R a, b; };
+    struct M { typename V::M a, b; };
+    static constexpr int32 W = 2 * V::W;
+
+    static R    load(const DspSample* p) { return {V::load(p), V::load(p + V::W)}; }
+    static void store(DspSample* p, R x) { V::store(p, x.a); V::store(p + V::W, x.b); }
+    static R    set1(DspSample x) { return {V::set1(x), V::set1(x)}; }
+    static R    zero() { return {V::zero(), V::zero()}; }
+    static R    add(R x, R y) { return {V::add(x.a, y.a), V::add(x.b, y.b)}; }
+    static R    sub(R x, R y) { return {V::sub(x.a, y.a), V::sub(x.b, y.b)}; }
+    static R    mul(R x, R y) { return {V::mul(x.a, y.a), V::mul(x.b, y.b)}; }
+    static R    div(R x, R y) { return {V::div(x.a, y.a), V::div(x.b, y.b)}; }
+    static R    sqrt(R x) { return {V::sqrt(x.a), V::sqrt(x.b)}; }
+    static R    abs(R x) { return {V::abs(x.a), V::abs(x.b)}; }
+    static M    gt(R x, R y) { return {V::gt(x.a, y.a), V::gt(x.b, y.b)}; }
+    static M    lt(R x, R y) { return {V::lt(x.a, y.a), V::lt(x.b, y.b)}; }
+    static M    isnan(R x) { return {V::isnan(x.a), V::isnan(x.b)}; }
+    static R    select(M m, R x, R y) { return {V::select(m.a, x.a, y.a), V::select(m.b, x.b, y.b)}; }
+    static R    curve(const GainCurve& g, R x) { return {V::curve(g, x.a), V::curve(g, x.b)}; }
+};
+
+/** V::curve() for sets without a gather: through memory, lane by lane. */
+template <typename V>
+typename V::R laneCurveFallback(const GainCurve& g, typename V::R env)
+{
+    alignas(64) DspSample envs[V::W];
+    alignas(64) DspSample gains[V::W];
+    V::store(envs, env);
+    laneCurveGains(g, envs, gains, V::W);
+    return V::load(gains);
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
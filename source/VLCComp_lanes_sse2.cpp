@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_lanes_kernel.h"
+
+#if VLCCOMP_LANES_X86
+#include <emmintrin.h>
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// SSE2: 2 doubles or 4 floats
+//------------------------------------------------------------------------
+#if VLCCOMP_FLOAT_ENGINE
+struct Sse2Lanes
+{
+    using R = __m128;
+    using M = __m128;
+    static constexpr int32 W = 4;
+
+    static R    load(const float* p) { return _mm_load_ps(p); }
+    static void store(float* p, R a) { _mm_store_ps(p, a); }
+    static R    set1(float x) { return _mm_set1_ps(x); }
+    static R    zero() { return _mm_setzero_ps(); }
+    static R    add(R a, R b) { return _mm_add_ps(a, b); }
+    static R    sub(R a, R b) { return _mm_sub_ps(a, b); }
+    static R    mul(R a, R b) { return _mm_mul_ps(a, b); }
+    static R    div(R a, R b) { return _mm_div_ps(a, b); }
+    static R    sqrt(R a) { return _mm_sqrt_ps(a); }
+    static R    abs(R a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static M    gt(R a, R b) { return _mm_cmpgt_ps(a, b); }
+    static M    lt(R a, R b) { return _mm_cmplt_ps(a, b); }
+    static M    isnan(R a) { return _mm_cmpunord_ps(a, a); }
+    static R    select(M m, R a, R b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static R    curve(const GainCurve& g, R env) { return laneCurveFallback<Sse2Lanes>(g, env); }
+};
+#else
+struct Sse2Lanes
+{
+    using R = __m128d;
+    using M = __m128d;
+    static constexpr int32 W = 2;
+
+    static R    load(const double* p) { return _mm_load_pd(p); }
+    static void store(double* p, R a) { _mm_store_pd(p, a); }
+    static R    set1(double x) { return _mm_set1_pd(x); }
+    static R    zero() { return _mm_setzero_pd(); }
+    static R    add(R a, R b) { return _mm_add_pd(a, b); }
+    static R    sub(R a, R b) { return _mm_sub_pd(a, b); }
+    static R    mul(R a, R b) { return _mm_mul_pd(a, b); }
+    static R    div(R a, R b) { return _mm_div_pd(a, b); }
+    static R    sqrt(R a) { return _mm_sqrt_pd(a); }
+    static R    abs(R a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static M    gt(R a, R b) { return _mm_cmpgt_pd(a, b); }
+    static M    lt(R a, R b) { return _mm_cmplt_pd(a, b); }
+    static M    isnan(R a) { return _mm_cmpunord_pd(a, a); }
+    static R    select(M m, R a, R b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static R    curve(const GainCurve& g, R env) { return laneCurveFallback<Sse2Lanes>(g, env); }
+};
+#endif
+
+void runSse2Lanes(const LaneCoefs& c, const LaneState& s, LaneCursor& cursor,
+                  const DspSample* in, DspSample* out, int32 frames)
+{
+    runLanes<LanePair<Sse2Lanes>>(c, s, cursor, in, out, frames);
+}
+} // namespace
+
+const LaneEngine laneEngineSse2 = {"sse2", LanePair<Sse2Lanes>::W, runSse2Lanes};
+
+//------------------------------------------------------------------------
+} // namespace yg331
+#endif
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_meters.h"
+#include "VLCComp_rtcheck.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+// token registry, only touched from the main thread
+//------------------------------------------------------------------------
+namespace {
+struct Registry
+{
+    std::mutex lock;
+    int64_t    nextToken = 1;
+    std::unordered_map<int64_t, std::weak_ptr<MeterChannel>> channels;
+};
+
+Registry& registry ()
+{
+    static Registry r;
+    return r;
+}
+} // namespace
+
+//------------------------------------------------------------------------
+// MeterChannel
+//------------------------------------------------------------------------
+std::shared_ptr<MeterChannel> MeterChannel::create ()
+{
+    std::shared_ptr<MeterChannel> channel (new MeterChannel);
+
+    Registry& r = registry ();
+    RT_LOCK_CHECK ();
+    std::lock_guard<std::mutex> guard (r.lock);
+    channel->token = r.nextToken++;
+    r.channels[channel->token] = channel;
+    return channel;
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<MeterChannel> MeterChannel::find (int64_t token)
+{
+    Registry& r = registry ();
+    RT_LOCK_CHECK ();
+    std::lock_guard<std::mutex> guard (r.lock);
+    auto it = r.channels.find (token);
+    return it != r.channels.end () ? it->second.lock () : nullptr;
+}
+
+//------------------------------------------------------------------------
+MeterChannel::~MeterChannel ()
+{
+    Registry& r = registry ();
+    RT_LOCK_CHECK ();
+    std::lock_guard<std::mutex> guard (r.lock);
+    r.channels.erase (token);
+}
+
+//------------------------------------------------------------------------
+// HistoryColumns
+//------------------------------------------------------------------------
+void HistoryColumns::add (const HistoryPoint& p)
+{
+    if (pendingEmpty)
+    {
+        pending = p;
+        pendingEmpty = false;
+    }
+    else
+    {
+        pending.levelMin = std::min (pending.levelMin, p.levelMin);
+        pending.levelMax = std::max (pending.levelMax, p.levelMax);
+        pending.grMin    = std::min (pending.grMin, p.grMin);
+        pending.grMax    = std::max (pending.grMax, p.grMax);
+        pending.duration += p.duration;
+    }
+
+    // a block longer than a column fills as many as it spans
+    constexpr float step = kSeconds / kColumns;
+    if (pending.duration >= step)
+    {
+        for (int n = std::min (int (pending.duration / step), kColumns); n > 0; n--)
+        {
+            head = (head + 1) % kColumns;
+            columns[head] = pending;
+        }
+        pendingEmpty = true;
+    }
+}
+
+//------------------------------------------------------------------------
+void HistoryColumns::clear ()
+{
+    for (auto& column : columns)
+        column = HistoryPoint ();
+    pendingEmpty = true;
+    head = kColumns - 1;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_shared.h"
+
+#include <memory>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  MeterValues
+//  One block worth of meter readings, in dB.
+//------------------------------------------------------------------------
+struct MeterValues
+{
+    ParamValue vuInLRMS   = -100.0, vuInRRMS   = -100.0;
+    ParamValue vuInLPeak  = -100.0, vuInRPeak  = -100.0;
+    ParamValue vuOutLRMS  = -100.0, vuOutRRMS  = -100.0;
+    ParamValue vuOutLPeak = -100.0, vuOutRPeak = -100.0;
+    ParamValue tpIn       = -100.0, tpOut      = -100.0;
+    ParamValue vuGR       = 0.0;
+};
+
+//------------------------------------------------------------------------
+//  HistoryPoint
+//  Detector level and gain reduction over one process block, min/max
+//  decimated, in dB. duration is the block length in seconds so the
+//  reader can lay points out in time whatever the block size.
+//------------------------------------------------------------------------
+struct HistoryPoint
+{
+    float levelMin = -100.f, levelMax = -100.f;
+    float grMin    = 0.f,    grMax    = 0.f;
+    float duration = 0.f;
+};
+
+//------------------------------------------------------------------------
+//  HistoryColumns
+//  UI side history, one min/max column per pixel. Points drained from the
+//  channel are merged into the newest column until it spans
+//  kSeconds / kColumns, so drawing costs one line per column however
+//  many blocks arrived.
+//------------------------------------------------------------------------
+class HistoryColumns
+{
+public:
+    static constexpr int   kColumns = 256;
+    static constexpr float kSeconds = 5.f;
+
+    void add (const HistoryPoint& p);
+    void clear ();
+
+    // i = 0 is the oldest column
+    const HistoryPoint& operator[] (int i) const { return columns[(head + 1 + i) % kColumns]; }
+
+private:
+    HistoryPoint columns[kColumns];
+    HistoryPoint pending;
+    bool         pendingEmpty = true;
+    int          head = kColumns - 1; // newest completed column
+};
+
+//------------------------------------------------------------------------
+//  MeterChannel
+//  Carries meter readings from the processor to the controller without
+//  IMessages, so process() neither allocates nor calls into the host.
+//  The processor creates one and announces its token once (off the audio
+//  thread); a controller in the same module looks the token up and then
+//  polls at UI rate. Shared ownership keeps it alive for whichever side
+//  goes away last. A controller in another process won't find the token
+//  and simply shows no meters.
+//------------------------------------------------------------------------
+class MeterChannel
+{
+public:
+    static std::shared_ptr<MeterChannel> create ();
+    static std::shared_ptr<MeterChannel> find (int64_t token);
+
+    ~MeterChannel ();
+
+    int64_t getToken () const { return token; }
+
+    TripleBuffer<MeterValues> meters; // process -> UI
+    RingBuffer<HistoryPoint, 1024> history; // process -> UI, a few seconds of small blocks
+
+private:
+    MeterChannel () = default;
+    int64_t token = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  AlignedPool
+//  One cache-line aligned block per instance that the sample-rate sized
+//  buffers are carved from. Laid out in setupProcessing: reserve() the sum
+//  of footprint()s, then take() each buffer in turn. Never touched from
+//  process().
+//------------------------------------------------------------------------
+class AlignedPool
+{
+public:
+    static constexpr size_t kAlignment = 64;
+
+    AlignedPool() = default;
+    AlignedPool(const AlignedPool&) = delete;
+    AlignedPool& operator=(const AlignedPool&) = delete;
+    ~AlignedPool() { release(); }
+
+    /** Bytes a take<T>(count) uses, padded so the next buffer stays aligned. */
+    template <typename T>
+    static constexpr size_t footprint(size_t count)
+    {
+        return (count * sizeof(T) + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    /** Resizes to exactly bytes, zeroed, and rewinds take(). */
+    bool reserve(size_t bytes)
+    {
+        if (bytes != size)
+        {
+            release();
+            if (bytes == 0)
+                return true;
+#if defined(_WIN32)
+            block = static_cast<char*>(_aligned_malloc(bytes, kAlignment));
+#else
+            void* p = nullptr;
+            block = (posix_memalign(&p, kAlignment, bytes) == 0) ? static_cast<char*>(p) : nullptr;
+#endif
+            if (!block)
+                return false;
+            size = bytes;
+        }
+        std::memset(block, 0, size);
+        used = 0;
+        return true;
+    }
+
+    template <typename T>
+    T* take(size_t count)
+    {
+        const size_t bytes = footprint<T>(count);
+        if (!block || used + bytes > size)
+            return nullptr;
+        T* p = reinterpret_cast<T*>(block + used);
+        used += bytes;
+        return p;
+    }
+
+    size_t capacity() const { return size; }
+
+    void release()
+    {
+        if (block)
+        {
+#if defined(_WIN32)
+            _aligned_free(block);
+#else
+            std::free(block);
+#endif
+        }
+        block = nullptr;
+        size  = 0;
+        used  = 0;
+    }
+
+private:
+    char*  block = nullptr;
+    size_t size  = 0;
+    size_t used  = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
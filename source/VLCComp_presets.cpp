@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_presets.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <mutex>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+// PresetLibrary
+//------------------------------------------------------------------------
+void PresetLibrary::loadFactory()
+{
+    struct Factory
+    {
+        const char* name;
+        ParamValue  rms_peak, attack, release, threshold, ratio, knee, makeup, mix; // plain
+    };
+    static const Factory factory[] = {
+        // name              RMS%   Att    Rel    Thr    Ratio  Knee  Makeup Mix
+        { "Default",         20.0,  25.0,  200.0, -11.0, 4.0,   5.0,  0.0,   100.0 },
+        { "Gentle Bus",      0.0,   30.0,  300.0, -8.0,  2.0,   8.0,  2.0,   100.0 },
+        { "Vocal Leveler",   10.0,  10.0,  150.0, -18.0, 3.0,   6.0,  4.0,   100.0 },
+        { "Drum Smash",      80.0,  1.5,   60.0,  -24.0, 10.0,  2.0,  8.0,   50.0  },
+        { "Peak Catcher",    100.0, 1.5,   50.0,  -3.0,  20.0,  1.0,  0.0,   100.0 },
+        { "Slow Glue",       0.0,   100.0, 600.0, -12.0, 1.5,   10.0, 1.5,   100.0 },
+    };
+
+    for (const auto& f : factory)
+    {
+        StateValues s;
+        s.v[kParamRMS_PEAK]  = Plain2Norm(f.rms_peak,  minRMS_PEAK,  maxRMS_PEAK);
+        s.v[kParamAttack]    = LogPlain2Norm(f.attack, minAttack,    maxAttack);
+        s.v[kParamRelease]   = Plain2Norm(f.release,   minRelease,   maxRelease);
+        s.v[kParamThreshold] = Plain2Norm(f.threshold, minThreshold, maxThreshold);
+        s.v[kParamRatio]     = Plain2Norm(f.ratio,     minRatio,     maxRatio);
+        s.v[kParamKnee]      = Plain2Norm(f.knee,      minKnee,      maxKnee);
+        s.v[kParamMakeup]    = Plain2Norm(f.makeup,    minMakeup,    maxMakeup);
+        s.v[kParamMix]       = Plain2Norm(f.mix,       minMix,       maxMix);
+        add(f.name, s);
+    }
+}
+
+//------------------------------------------------------------------------
+void PresetLibrary::add(const char* name, const StateValues& values)
+{
+    Preset p;
+    std::memset(p.name, 0, sizeof(p.name));
+    std::strncpy(p.name, name, kPresetNameSize - 1);
+    p.values = values;
+
+    byName.emplace(p.name, size());
+    presets.push_back(p);
+}
+
+//------------------------------------------------------------------------
+bool PresetLibrary::loadIndex(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    // A bad index is skipped whole: whatever it added goes again, and a
+    // failed allocation doesn't get out of plug-in initialization
+    const int32 first = size();
+    bool ok = false;
+    try
+    {
+        ok = readIndex(file);
+    }
+    catch (const std::exception&)
+    {
+        ok = false;
+    }
+    std::fclose(file);
+
+    if (!ok)
+    {
+        presets.resize(first);
+        for (auto it = byName.begin(); it != byName.end();)
+            it = it->second >= first ? byName.erase(it) : std::next(it);
+    }
+    return ok;
+}
+
+//------------------------------------------------------------------------
+bool PresetLibrary::readIndex(FILE* file)
+{
+    uint32 header[4] = {0, };
+    if (std::fread(header, sizeof(uint32), 4, file) != 4
+        || header[0] != kPresetIndexMagic
+        || header[3] > kStateMaxParams)
+        return false;
+
+    const uint32 count     = header[2];
+    const uint32 numParams = header[3];
+    const uint32 numKnown  = std::min<uint32>(numParams, kNumParams);
+
+    // The count is only as good as the file: it has to hold that many
+    // records before anything is sized on it
+    const long start = std::ftell(file);
+    if (start < 0 || std::fseek(file, 0, SEEK_END) != 0)
+        return false;
+    const long end = std::ftell(file);
+    if (end < start || std::fseek(file, start, SEEK_SET) != 0)
+        return false;
+    const uint64_t recordSize = kPresetNameSize + uint64_t(numParams) * sizeof(double);
+    if (uint64_t(count) * recordSize > uint64_t(end - start))
+        return false;
+
+    presets.reserve(presets.size() + count);
+    byName.reserve(byName.size() + count);
+
+    std::vector<double> record(numParams);
+    for (uint32 i = 0; i < count; i++)
+    {
+        char name[kPresetNameSize];
+        if (std::fread(name, 1, kPresetNameSize, file) != kPresetNameSize
+            || std::fread(record.data(), sizeof(double), numParams, file) != numParams)
+            return false;
+
+        name[kPresetNameSize - 1] = 0;
+        StateValues s;
+        for (uint32 id = 0; id < numKnown; id++)
+            s.set(id, record[id]);
+        add(name, s);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool PresetLibrary::saveIndex(const std::string& path, int32 first) const
+{
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    const uint32 count = first < size() ? static_cast<uint32>(size() - first) : 0;
+    const uint32 header[4] = { kPresetIndexMagic, kPresetIndexVersion, count, kNumParams };
+
+    bool ok = std::fwrite(header, sizeof(uint32), 4, file) == 4;
+    for (int32 i = first; ok && i < size(); i++)
+    {
+        ok = std::fwrite(presets[i].name, 1, kPresetNameSize, file) == kPresetNameSize
+          && std::fwrite(presets[i].values.v, sizeof(double), kNumParams, file) == kNumParams;
+    }
+
+    return (std::fclose(file) == 0) && ok;
+}
+
+//------------------------------------------------------------------------
+int32 PresetLibrary::indexOf(const std::string& name) const
+{
+    auto it = byName.find(name);
+    return it != byName.end() ? it->second : -1;
+}
+
+//------------------------------------------------------------------------
+int32 PresetLibrary::indexFromNormalized(ParamValue value) const
+{
+    if (presets.empty())
+        return -1;
+    const int32 last = size() - 1;
+    return static_cast<int32>(LIMIT(std::floor(value * last + 0.5), 0.0, static_cast<double>(last)));
+}
+
+//------------------------------------------------------------------------
+std::string PresetLibrary::userIndexPath()
+{
+    // Next to the user's VST3 presets for this plug-in
+#if defined(_WIN32)
+    const char* base = std::getenv("APPDATA");
+    const char* sub  = "\\VST3 Presets\\yg331\\VLC Compressor\\presets.idx";
+#elif defined(__APPLE__)
+    const char* base = std::getenv("HOME");
+    const char* sub  = "/Library/Audio/Presets/yg331/VLC Compressor/presets.idx";
+#else
+    const char* base = std::getenv("HOME");
+    const char* sub  = "/.vst3/presets/yg331/VLC Compressor/presets.idx";
+#endif
+    if (!base)
+        return std::string();
+    return std::string(base) + sub;
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const PresetLibrary> PresetLibrary::shared()
+{
+    static std::mutex lock;
+    static std::weak_ptr<const PresetLibrary> current;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (std::shared_ptr<const PresetLibrary> library = current.lock())
+        return library;
+
+    auto library = std::make_shared<PresetLibrary>();
+    library->loadFactory();
+    library->loadIndex(userIndexPath());
+    current = library;
+    return library;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
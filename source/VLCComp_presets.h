@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_state.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  PresetLibrary
+//  Factory presets followed by the user presets of an on-disk index.
+//
+//  Index file: uint32 magic, uint32 version, uint32 count, uint32 numParams,
+//  then count fixed-size records { char name[kPresetNameSize], double v[numParams] }.
+//  Records are read in one pass and addressed by position afterwards, so
+//  enumerating and switching is O(1) per preset. Values are indexed by
+//  ParamID, extra ones from a newer version are dropped and missing ones
+//  keep their default. An index that doesn't hold the records its header
+//  claims is skipped whole.
+//
+//  Plug-in instances share one library through shared(), read-only, so
+//  500 instances over thousands of user presets hold them once.
+//------------------------------------------------------------------------
+static constexpr uint32 kPresetIndexMagic   = 0x50434C56; // "VLCP" little endian
+static constexpr uint32 kPresetIndexVersion = 1;
+static constexpr int32  kPresetNameSize     = 32;
+
+class PresetLibrary
+{
+public:
+    struct Preset
+    {
+        char        name[kPresetNameSize];
+        StateValues values;
+    };
+
+    void loadFactory();
+    bool loadIndex(const std::string& path);
+    bool saveIndex(const std::string& path, int32 first = 0) const;
+
+    void add(const char* name, const StateValues& values);
+    void clear() { presets.clear(); byName.clear(); }
+
+    int32 size() const { return static_cast<int32>(presets.size()); }
+    const Preset& operator[](int32 index) const { return presets[index]; }
+    int32 indexOf(const std::string& name) const;
+
+    // Program-change parameter value <-> preset index
+    int32 indexFromNormalized(ParamValue value) const;
+
+    static std::string userIndexPath();
+
+    /** Factory and user presets, loaded on first use and kept while anyone
+     *  holds the handle; the next first use reads the index again. Locks
+     *  and reads the disk, not for the audio thread. */
+    static std::shared_ptr<const PresetLibrary> shared();
+
+private:
+    bool readIndex(FILE* file);
+
+    std::vector<Preset> presets;
+    std::unordered_map<std::string, int32> byName;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
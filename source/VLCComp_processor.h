@@ -5,11 +5,14 @@
 #pragma once
 
 #include "VLCComp_shared.h"
+#include "VLCComp_state.h"
+#include "VLCComp_presets.h"
+#include "VLCComp_meters.h"
+#include "VLCComp_core.h"
+#include "VLCComp_curvecache.h"
 #include "public.sdk/source/vst/vstaudioeffect.h"
 
 #include <cmath>
-#define decibelsToGain(f_db)  (std::pow(10.0, f_db / 20.0))
-#define gainToDecibels(f_lin) ((f_lin>0)?(20.0 * log10(f_lin)):(-100.0))
 
 namespace yg331 {
 class LevelEnvelopeFollower
@@ -23,9 +26,12 @@ public:
     }
 
     void setChannel(const int channels) {
-        state.resize(channels, 0.0);
+        state.assign(channels, 0.0);
+        state.shrink_to_fit();
     }
 
+    size_t footprint() const { return state.capacity() * sizeof(double); }
+
     enum detectionType {Peak, RMS};
     void setType(detectionType _type)
     {
@@ -111,6 +117,9 @@ public:
 	
 	/** Called at the end before destructor */
 	Steinberg::tresult PLUGIN_API terminate () SMTG_OVERRIDE;
+
+	/** Connects with the controller, announces the meter channel */
+	Steinberg::tresult PLUGIN_API connect (Steinberg::Vst::IConnectionPoint* other) SMTG_OVERRIDE;
 	
 	/** Switch the Plug-in on/off */
 	Steinberg::tresult PLUGIN_API setActive (Steinberg::TBool state) SMTG_OVERRIDE;
@@ -131,6 +140,9 @@ public:
 	Steinberg::tresult PLUGIN_API setState (Steinberg::IBStream* state) SMTG_OVERRIDE;
 	Steinberg::tresult PLUGIN_API getState (Steinberg::IBStream* state) SMTG_OVERRIDE;
 
+	/** Heap and object bytes this instance holds for the current setup. */
+	size_t getMemoryFootprint() const;
+
 //------------------------------------------------------------------------
 protected:
     using SampleRate = Steinberg::Vst::SampleRate;
@@ -139,66 +151,69 @@ protected:
     using int32      = Steinberg::int32;
     using uint32     = Steinberg::uint32;
     
+    // Sub-block scheduling: host blocks of any size run on the core's
+    // CompressorCore::kSubBlock grid. Parameter points apply from the start
+    // of the sub-block they fall in, meters go out every meterPeriod frames
+    // on a boundary as well, so neither depends on the host's block size.
+    static constexpr int32 kMaxParamQueues = kNumParams + 1;   // + program change
+    struct ParamCursor
+    {
+        Steinberg::Vst::IParameterChanges* changes = nullptr;
+        int32 numQueues = 0;
+        int32 next[kMaxParamQueues] = {};       // first point not applied yet, per queue
+        bool  changed = false;
+    };
+    void applyParamChanges(ParamCursor& cursor, int32 upTo); // points before sample upTo
+    void publishMeters(int32 numChannels);
+
     template <typename SampleType>
-    void processAudio(SampleType** inputs, SampleType** outputs, int32 numChannels, SampleRate getSampleRate, int32 sampleFrames);
-    
-    // Parameters
-    bool       pBypass     = false;
-    ParamValue pInput      = nrmInput;
-    ParamValue pOutput     = nrmOutput;
-    
-    ParamValue pRMS_PEAK   = nrmRMS_PEAK;
-    ParamValue pAttack     = nrmAttack;
-    ParamValue pRelease    = nrmRelease;
-    ParamValue pThreshold  = nrmThreshold;
-    ParamValue pRatio      = nrmRatio;
-    ParamValue pKnee       = nrmKnee;
-    ParamValue pMakeup     = nrmMakeup;
-    ParamValue pMix        = nrmMix;
-    bool       pSoftBypass = false;
+    void processSubBlocks(SampleType** inputs, SampleType** outputs, int32 numChannels, int32 sampleFrames,
+                          bool silent, ParamCursor& cursor);
     
-    ParamValue pZoom       = 2.0 / 6.0;
-    ParamValue pOS         = 0.0;
-    
-    // VU metering ----------------------------------------------------------------
+    // Host and cross-thread side --------------------------------------------
+    SampleRate SR = 48000.0;
+    CompParams hostParams;                      // setState/getState thread only
+    TripleBuffer<CompParams> paramsToAudio;     // setState -> process
+    TripleBuffer<CompParams> paramsFromAudio;   // process  -> getState
+
+    // Static curves, shared module wide and taken off the audio thread;
+    // process() only ever sees raw pointers into these handles
+    CurveFeed          curvesToAudio;       // setState, builder -> process
+    CurveCache::Handle setupCurve;          // params at setupProcessing
+
+    // Presets, one read-only library for every instance
+    std::shared_ptr<const PresetLibrary> presets;
+    ParamValue lastProgram = -1.0;
+    void applyPreset(int32 index);
+    std::shared_ptr<MeterChannel> meterChannel;
+
+    // Audio thread -------------------------------------------------------------
+    // Written every block, kept together from a fresh cache line on so the
+    // members above, which other threads write, never share one with it.
+    // The per-sample state is the core's own, aligned apart again.
+    alignas(64) CompParams params;
+    CompressorCore core;                        // audio thread only, but for setupProcessing
+
+    // VU metering, buffers out of line
     LevelEnvelopeFollower VuInputRMS, VuOutputRMS;
     LevelEnvelopeFollower VuInputPeak, VuOutputPeak;
     std::vector<ParamValue> fInputVuRMS, fOutputVuRMS;  // for each channel
     std::vector<ParamValue> fInputVuPeak, fOutputVuPeak;
     Sample64 truePeakIn = 0.0, truePeakOut = 0.0;
     Sample64 gainReduction = 0.0;
+    DspSample historyEnvMin = 0.0, historyEnvMax = 0.0;   // detector, per block
+    DspSample historyGainMin = 1.0, historyGainMax = 1.0;
+    int32 meterPeriod = CompressorCore::kSubBlock;   // frames, set in setupProcessing
+    int32 meterFrames = 0;                           // since the last publish
+    bool  meterLive   = false;                       // and whether the core ran since
+
+    // Feeds the meters from inside the core's sample loop
+    struct MeterTap;
     
-    // Internal Variables
-    SampleRate SR = 48000.0;
-    Sample64 f_num = 0.0;
-    
-    Sample64 f_sum = 0.0;
-    Sample64 f_amp = 0.0;
-    Sample64 f_gain = 1.0;
-    Sample64 f_gain_out = 1.0;
-    Sample64 f_env = 0.0;
-    Sample64 f_env_rms = 0.0;
-    Sample64 f_env_peak = 0.0;
-    uint32   i_count = 0;
-
-    rms_env   p_rms;
-    lookahead p_la;
-    
-    typedef union
-    {
-        float f;
-        int32_t i;
-
-    } ls_pcast32;
-    
-    static double Db2Lin(double f_db);
-    static double Lin2Db(double f_lin);
-    static void       RoundToZero     ( ParamValue * );
-    static ParamValue Max             ( ParamValue, ParamValue );
-    static ParamValue Clamp           ( ParamValue, ParamValue, ParamValue );
-    static int        Round           ( float );
-    static ParamValue RmsEnvProcess   ( rms_env *, const ParamValue );
-    static void       BufferProcess   ( ParamValue *, ParamValue *, int, ParamValue, ParamValue, lookahead * );
+    template <typename T>
+    static T Db2Lin(T f_db) { return std::pow(T(10.0), f_db / T(20.0)); }
+    template <typename T>
+    static T Lin2Db(T f_lin) { return (f_lin > T(0.0)) ? (T(20.0) * std::log10(f_lin)) : T(-100.0); }
 };
 
 //------------------------------------------------------------------------
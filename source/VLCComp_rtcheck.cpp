@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_rtcheck.h"
+
+#if VLCCOMP_RT_CHECK
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace yg331 {
+namespace rtcheck {
+
+// initial-exec: the malloc hooks below read it, a lazily allocated TLS
+// block would call malloc to get there
+#if defined(__GNUC__)
+static thread_local int audioDepth __attribute__((tls_model("initial-exec"))) = 0;
+#else
+static thread_local int audioDepth = 0;
+#endif
+
+bool isAudioThread () { return audioDepth > 0; }
+
+AudioScope::AudioScope ()  { audioDepth++; }
+AudioScope::~AudioScope () { audioDepth--; }
+
+void violation (const char* what)
+{
+    // leave the scope first so reporting can't recurse into us
+    audioDepth = 0;
+    std::fprintf (stderr, "VLC Compressor: realtime violation on the audio thread: %s\n", what);
+    std::fflush (stderr);
+    std::abort ();
+}
+
+} // namespace rtcheck
+} // namespace yg331
+
+//------------------------------------------------------------------------
+// Module-wide allocation hooks
+//------------------------------------------------------------------------
+using yg331::rtcheck::isAudioThread;
+using yg331::rtcheck::violation;
+
+void* operator new (std::size_t size)
+{
+    if (isAudioThread ()) violation ("operator new");
+    if (void* p = std::malloc (size ? size : 1)) return p;
+    throw std::bad_alloc ();
+}
+
+void* operator new[] (std::size_t size)
+{
+    if (isAudioThread ()) violation ("operator new[]");
+    if (void* p = std::malloc (size ? size : 1)) return p;
+    throw std::bad_alloc ();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (isAudioThread ()) violation ("operator new");
+    return std::malloc (size ? size : 1);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (isAudioThread ()) violation ("operator new[]");
+    return std::malloc (size ? size : 1);
+}
+
+void operator delete (void* p) noexcept
+{
+    if (p && isAudioThread ()) violation ("operator delete");
+    std::free (p);
+}
+
+void operator delete[] (void* p) noexcept
+{
+    if (p && isAudioThread ()) violation ("operator delete[]");
+    std::free (p);
+}
+
+void operator delete (void* p, std::size_t) noexcept   { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept { operator delete[] (p); }
+
+//------------------------------------------------------------------------
+// Over-aligned types (alignas beyond the default) go through these
+//------------------------------------------------------------------------
+static void* alignedAlloc (std::size_t size, std::align_val_t align)
+{
+    std::size_t alignment = static_cast<std::size_t> (align);
+    if (alignment < sizeof (void*))
+        alignment = sizeof (void*);
+#if defined(_MSC_VER)
+    return _aligned_malloc (size ? size : 1, alignment);
+#else
+    void* p = nullptr;
+    return posix_memalign (&p, alignment, size ? size : 1) == 0 ? p : nullptr;
+#endif
+}
+
+static void alignedFree (void* p)
+{
+#if defined(_MSC_VER)
+    _aligned_free (p);
+#else
+    std::free (p);
+#endif
+}
+
+void* operator new (std::size_t size, std::align_val_t align)
+{
+    if (isAudioThread ()) violation ("operator new");
+    if (void* p = alignedAlloc (size, align)) return p;
+    throw std::bad_alloc ();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t align)
+{
+    if (isAudioThread ()) violation ("operator new[]");
+    if (void* p = alignedAlloc (size, align)) return p;
+    throw std::bad_alloc ();
+}
+
+void* operator new (std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    if (isAudioThread ()) violation ("operator new");
+    return alignedAlloc (size, align);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    if (isAudioThread ()) violation ("operator new[]");
+    return alignedAlloc (size, align);
+}
+
+void operator delete (void* p, std::align_val_t) noexcept
+{
+    if (p && isAudioThread ()) violation ("operator delete");
+    alignedFree (p);
+}
+
+void operator delete[] (void* p, std::align_val_t) noexcept
+{
+    if (p && isAudioThread ()) violation ("operator delete[]");
+    alignedFree (p);
+}
+
+void operator delete (void* p, std::size_t, std::align_val_t align) noexcept   { operator delete (p, align); }
+void operator delete[] (void* p, std::size_t, std::align_val_t align) noexcept { operator delete[] (p, align); }
+
+//------------------------------------------------------------------------
+// The C allocator, glibc only: calls from this module to malloc and
+// friends land here and go on to glibc's own entry points. A plug-in
+// links with -Bsymbolic-functions in this build so that its own calls
+// bind to these and to the operators above, not to the host's.
+// Elsewhere only operator new/delete are checked.
+//------------------------------------------------------------------------
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc (std::size_t);
+void* __libc_calloc (std::size_t, std::size_t);
+void* __libc_realloc (void*, std::size_t);
+void* __libc_memalign (std::size_t, std::size_t);
+void  __libc_free (void*);
+
+void* malloc (std::size_t size) __THROW
+{
+    if (isAudioThread ()) violation ("malloc");
+    return __libc_malloc (size);
+}
+
+void* calloc (std::size_t count, std::size_t size) __THROW
+{
+    if (isAudioThread ()) violation ("calloc");
+    return __libc_calloc (count, size);
+}
+
+void* realloc (void* p, std::size_t size) __THROW
+{
+    if (isAudioThread ()) violation ("realloc");
+    return __libc_realloc (p, size);
+}
+
+int posix_memalign (void** p, std::size_t alignment, std::size_t size) __THROW
+{
+    if (isAudioThread ()) violation ("posix_memalign");
+    if (alignment < sizeof (void*) || (alignment & (alignment - 1)))
+        return 22; // EINVAL
+    *p = __libc_memalign (alignment, size);
+    return *p ? 0 : 12; // ENOMEM
+}
+
+void* aligned_alloc (std::size_t alignment, std::size_t size) __THROW
+{
+    if (isAudioThread ()) violation ("aligned_alloc");
+    return __libc_memalign (alignment, size);
+}
+
+void free (void* p) __THROW
+{
+    if (p && isAudioThread ()) violation ("free");
+    __libc_free (p);
+}
+
+} // extern "C"
+#endif // __GLIBC__
+
+#endif // VLCCOMP_RT_CHECK
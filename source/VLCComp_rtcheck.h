@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+//------------------------------------------------------------------------
+//  Realtime-safety checker
+//
+//  Configure with -DVLCCOMP_RT_CHECK=ON. Code inside RT_AUDIO_SCOPE() is
+//  marked as audio thread, and any heap allocation or RT_LOCK_CHECK()
+//  point reached from there is reported on stderr and aborts, so a host
+//  or test run fails on the first violation. Allocations are operator
+//  new/delete, aligned ones included, which std containers go through;
+//  with glibc also malloc, calloc, realloc, posix_memalign, aligned_alloc
+//  and free called from this module. Elsewhere (macOS, Windows) the C
+//  allocator isn't checked. Without the option everything compiles away.
+//------------------------------------------------------------------------
+#if VLCCOMP_RT_CHECK
+
+namespace yg331 {
+namespace rtcheck {
+
+void violation (const char* what);
+bool isAudioThread ();
+
+struct AudioScope
+{
+    AudioScope ();
+    ~AudioScope ();
+    AudioScope (const AudioScope&) = delete;
+    AudioScope& operator= (const AudioScope&) = delete;
+};
+
+} // namespace rtcheck
+} // namespace yg331
+
+#define RT_AUDIO_SCOPE()  yg331::rtcheck::AudioScope _rtAudioScope
+#define RT_LOCK_CHECK()   { if (yg331::rtcheck::isAudioThread ()) yg331::rtcheck::violation ("lock"); }
+
+#else
+
+#define RT_AUDIO_SCOPE()
+#define RT_LOCK_CHECK()
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "pluginterfaces/vst/vsttypes.h"
 
+#include <atomic>
 #include <cmath>
 
 namespace yg331 {
@@ -14,6 +15,15 @@ using ParamValue = Steinberg::Vst::ParamValue;
 using int32      = Steinberg::int32;
 using uint32     = Steinberg::uint32;
 
+// Internal DSP precision of the detector, gain computer and delay line.
+// Double by default; the VLCCOMP_FLOAT_ENGINE build option switches to float,
+// halving state size and doubling the lanes per vector in those stages.
+#if VLCCOMP_FLOAT_ENGINE
+using DspSample  = float;
+#else
+using DspSample  = double;
+#endif
+
 #define RMS_BUF_SIZE    (1920)
 #define LOOKAHEAD_SIZE  ((RMS_BUF_SIZE)<<1)
 #define AOUT_CHAN_MAX   9
@@ -21,28 +31,137 @@ using uint32     = Steinberg::uint32;
 #define LIN_INTERP(f,a,b) ((a) + (f) * ( (b) - (a) ))
 #define LIMIT(v,l,u)      (v < l ? l : ( v > u ? u : v ))
 
+// The buffers below point into the processor's AlignedPool, sized in
+// setupProcessing to i_count for the current sample rate (the *_SIZE
+// defines above are only the upper bounds).
 typedef struct rms_env
 {
-    ParamValue pf_buf[RMS_BUF_SIZE] = {0.0, };
+    DspSample* pf_buf = nullptr;      /* i_count mean squares */
     uint32     i_pos = 0;
     uint32     i_count = 0;
-    ParamValue f_sum = 0.0;
+    DspSample  f_sum = 0.0;
 
 } rms_env;
 
 typedef struct lookahead
 {
-    struct
-    {
-        ParamValue pf_vals[AOUT_CHAN_MAX] = {0.0, };
-        ParamValue f_lev_in = 0.0;
-
-    } p_buf[LOOKAHEAD_SIZE];
+    DspSample* pf_vals = nullptr;     /* i_count frames of i_channels samples */
+    DspSample* pf_lev_in = nullptr;   /* i_lev_count peak levels, at the detector rate */
+    uint32 i_channels = 0;
     uint32 i_pos = 0;
     uint32 i_count = 0;
+    uint32 i_lev_pos = 0;
+    uint32 i_lev_count = 0;
 
 } lookahead;
 
+// Sidechain decimation at high sample rates: the detector sees one frame
+// per i_factor audio frames, their level and mean square, and the audio
+// gets the detector gains interpolated linearly, one frame behind.
+typedef struct decimator
+{
+    DspSample f_max = 0.0;            /* peak of the frames so far */
+    DspSample f_sum = 0.0;            /* sum of their levels */
+    DspSample f_pow = 0.0;            /* and of their squares */
+    DspSample f_gain = 1.0;           /* gain the interpolation starts from */
+    DspSample f_step = 0.0;           /* per audio frame */
+    uint32 i_factor = 1;
+    uint32 i_phase = 0;               /* frames so far */
+
+} decimator;
+
+// Anticipating peak detector over the lookahead line: the running maximum
+// of the levels in it, kept as a monotonic deque (levels decreasing from
+// front to back, each with the frame it came in at), and the last
+// i_lev_count maxima, which a moving average of i_ramp of them turns into
+// the attack. Detector frames throughout, like pf_lev_in.
+typedef struct peak_window
+{
+    DspSample* pf_max = nullptr;      /* i_size deque levels, ring from i_head */
+    uint32*    pi_at = nullptr;       /* their frames */
+    DspSample* pf_ramp = nullptr;     /* i_lev_count window maxima, at the level position */
+    DspSample  f_ramp_sum = 0.0;      /* of the last i_ramp of them */
+    uint32 i_head = 0;
+    uint32 i_len = 0;
+    uint32 i_size = 0;
+    uint32 i_ramp = 0;                /* 0: not running, primed on first use */
+
+} peak_window;
+
+//------------------------------------------------------------------------
+//  TripleBuffer
+//  Lock-free single-producer / single-consumer handoff of a value type.
+//  The writer fills back() and push()es it, the reader fetch()es and uses
+//  front(). Neither side ever waits or allocates.
+//------------------------------------------------------------------------
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& back() { return slots[backIndex]; }
+    const T& front() const { return slots[frontIndex]; }
+
+    void push()
+    {
+        backIndex = middle.exchange(backIndex | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    bool fetch()
+    {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0)
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+private:
+    static constexpr int kIndexMask = 3;
+    static constexpr int kFresh     = 4;
+
+    T   slots[3];
+    int backIndex  = 0;
+    int frontIndex = 1;
+    std::atomic<int> middle {2};
+};
+
+//------------------------------------------------------------------------
+//  RingBuffer
+//  Lock-free single-producer / single-consumer FIFO of a value type with a
+//  power-of-two capacity. push() drops the value when the reader has
+//  fallen behind instead of waiting; pop() returns false when empty.
+//------------------------------------------------------------------------
+template <typename T, uint32 Capacity>
+class RingBuffer
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& value)
+    {
+        const uint32 w = writePos.load(std::memory_order_relaxed);
+        if (w - readPos.load(std::memory_order_acquire) >= Capacity)
+            return false;
+        slots[w & (Capacity - 1)] = value;
+        writePos.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        const uint32 r = readPos.load(std::memory_order_relaxed);
+        if (r == writePos.load(std::memory_order_acquire))
+            return false;
+        value = slots[r & (Capacity - 1)];
+        readPos.store(r + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T slots[Capacity];
+    std::atomic<uint32> writePos {0};
+    std::atomic<uint32> readPos  {0};
+};
+
 typedef enum {
     overSample_1x,
     overSample_2x,
@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_shared.h"
+#include "VLCComp_cids.h"
+
+#include "base/source/fstreamer.h"
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  Persistent state chunk
+//
+//  uint32 magic, uint32 version, uint32 count,
+//  then count x { uint32 ParamID, double normalized value }
+//
+//  Unknown IDs are skipped and missing IDs keep their default, so
+//  parameters can be added or dropped without breaking saved sessions.
+//  A stream that does not start with the magic is read as the original
+//  positional layout (v0). Reading never allocates.
+//------------------------------------------------------------------------
+static constexpr uint32 kStateMagic     = 0x43434C56; // "VLCC" little endian
+static constexpr uint32 kStateVersion   = 1;
+static constexpr uint32 kStateMaxParams = 4096;       // sanity bound on corrupt counts
+
+struct StateValues
+{
+    ParamValue v[kNumParams];
+
+    StateValues()
+    {
+        v[kParamBypass]     = 0.0;
+        v[kParamZoom]       = 2.0 / 6.0;
+        v[kParamOS]         = 0.0;
+        v[kParamInput]      = nrmInput;
+        v[kParamOutput]     = nrmOutput;
+        v[kParamRMS_PEAK]   = nrmRMS_PEAK;
+        v[kParamAttack]     = nrmAttack;
+        v[kParamRelease]    = nrmRelease;
+        v[kParamThreshold]  = nrmThreshold;
+        v[kParamRatio]      = nrmRatio;
+        v[kParamKnee]       = nrmKnee;
+        v[kParamMakeup]     = nrmMakeup;
+        v[kParamMix]        = nrmMix;
+        v[kParamSoftBypass] = 0.0;
+        v[kParamAnticipate] = 0.0;
+    }
+
+    void set(uint32 id, ParamValue value)
+    {
+        if (id >= kNumParams) return;          // from a newer version, ignore
+        if (!(value == value)) return;         // NaN, keep default
+        v[id] = LIMIT(value, 0.0, 1.0);
+    }
+};
+
+//------------------------------------------------------------------------
+inline void readLegacyState(Steinberg::IBStreamer& streamer, int32 savedBypass, StateValues& s)
+{
+    // v0: fixed sequence, fields missing at the end keep their default
+    static const uint32 order[] = {
+        kParamZoom, kParamOS, kParamInput, kParamOutput, kParamRMS_PEAK, kParamAttack,
+        kParamRelease, kParamThreshold, kParamRatio, kParamKnee, kParamMakeup, kParamMix
+    };
+
+    s.v[kParamBypass] = savedBypass > 0 ? 1.0 : 0.0;
+
+    for (uint32 id : order)
+    {
+        ParamValue value;
+        if (streamer.readDouble(value) == false) return;
+        s.set(id, value);
+    }
+
+    int32 savedSoftBypass;
+    if (streamer.readInt32(savedSoftBypass) == false) return;
+    s.v[kParamSoftBypass] = savedSoftBypass > 0 ? 1.0 : 0.0;
+}
+
+//------------------------------------------------------------------------
+inline bool readState(Steinberg::IBStream* state, StateValues& s)
+{
+    if (!state)
+        return false;
+
+    Steinberg::IBStreamer streamer (state, Steinberg::kLittleEndian);
+
+    int32 head = 0;
+    if (streamer.readInt32(head) == false)
+        return true; // empty stream, defaults
+
+    if (static_cast<uint32>(head) != kStateMagic)
+    {
+        readLegacyState(streamer, head, s);
+        return true;
+    }
+
+    uint32 version = 0, count = 0;
+    if (streamer.readInt32u(version) == false) return false;
+    if (streamer.readInt32u(count)   == false) return false;
+    if (count > kStateMaxParams)               return false;
+
+    // All versions so far share the ID/value pair layout, a future
+    // version that changes it has to bump the magic instead.
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32     id;
+        ParamValue value;
+        if (streamer.readInt32u(id)   == false) return false;
+        if (streamer.readDouble(value) == false) return false;
+        s.set(id, value);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+inline bool writeState(Steinberg::IBStream* state, const StateValues& s)
+{
+    if (!state)
+        return false;
+
+    Steinberg::IBStreamer streamer (state, Steinberg::kLittleEndian);
+
+    bool ok = streamer.writeInt32u(kStateMagic)
+           && streamer.writeInt32u(kStateVersion)
+           && streamer.writeInt32u(kNumParams);
+
+    for (uint32 id = 0; ok && id < kNumParams; id++)
+    {
+        ok = streamer.writeInt32u(id)
+          && streamer.writeDouble(s.v[id]);
+    }
+    return ok;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
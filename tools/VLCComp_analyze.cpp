@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+//  vlccomp_analyze
+//  Gain reduction the compressor would apply to a file, without rendering
+//  it: runs only the detector and gain computer and writes one CSV row of
+//  min/max envelope and gain (dB) per window.
+//
+//  vlccomp_analyze [options] input.wav [output.csv]
+//------------------------------------------------------------------------
+
+#include "VLCComp_analysis.h"
+#include "VLCComp_options.h"
+#include "VLCComp_wavfile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+//------------------------------------------------------------------------
+void usage()
+{
+    std::fprintf(stderr, "usage: vlccomp_analyze [options] input.wav [output.csv]\n");
+    printParamOptions(stderr, false);
+    std::fprintf(stderr,
+        "  --window <ms>       decimation window (default 10)\n"
+        "writes time_s,env_min_db,env_max_db,gr_min_db,gr_max_db to stdout\n"
+        "unless an output file is given\n");
+}
+
+//------------------------------------------------------------------------
+void writePoints(FILE* out, const std::vector<AnalysisPoint>& points)
+{
+    for (const auto& p : points)
+        std::fprintf(out, "%.6f,%.2f,%.2f,%.2f,%.2f\n", p.time, p.envMinDb, p.envMaxDb, p.grMinDb, p.grMaxDb);
+}
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    CompParams params;
+    double windowMs = 10.0;
+    const char* inPath  = nullptr;
+    const char* outPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (arg[0] == '-' && arg[1] == '-')
+        {
+            if (i + 1 >= argc)
+            {
+                usage();
+                return 2;
+            }
+            const double v = std::atof(argv[++i]);
+            if (!std::strcmp(arg, "--window"))
+                windowMs = v;
+            else if (!parseParamOption(arg, v, params))
+            {
+                usage();
+                return 2;
+            }
+        }
+        else if (!inPath)  inPath  = arg;
+        else if (!outPath) outPath = arg;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!inPath)
+    {
+        usage();
+        return 2;
+    }
+
+    WavReader reader;
+    if (!reader.open(inPath))
+    {
+        std::fprintf(stderr, "vlccomp_analyze: cannot read %s (PCM 16/24/32 or float 32/64 WAV)\n", inPath);
+        return 1;
+    }
+
+    FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (!out)
+    {
+        std::fprintf(stderr, "vlccomp_analyze: cannot write %s\n", outPath);
+        return 1;
+    }
+
+    const double SR = reader.getSampleRate();
+    GainAnalyzer analyzer;
+    if (!analyzer.setup(SR, params, static_cast<uint32>(windowMs * 0.001 * SR + 0.5)))
+    {
+        std::fprintf(stderr, "vlccomp_analyze: out of memory\n");
+        return 1;
+    }
+
+    // stream the file through in blocks, memory stays flat for any length
+    constexpr int32 kBlock = 8192;
+    const int32 numChannels = reader.getChannels();
+    std::vector<double>  buffer(size_t(kBlock) * numChannels);
+    std::vector<double*> channels(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+        channels[ch] = buffer.data() + size_t(ch) * kBlock;
+
+    std::fprintf(out, "time_s,env_min_db,env_max_db,gr_min_db,gr_max_db\n");
+    int32 got;
+    while ((got = reader.read(channels.data(), kBlock)) > 0)
+    {
+        analyzer.process(channels.data(), numChannels, got);
+        writePoints(out, analyzer.getPoints());
+        analyzer.clearPoints();
+    }
+    analyzer.finish();
+    writePoints(out, analyzer.getPoints());
+
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
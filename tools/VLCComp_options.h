@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_core.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  Compressor settings on the command line, in plain units, shared by the
+//  tools. Values out of range are clamped like the editor knobs would.
+//------------------------------------------------------------------------
+inline bool parseParamOption(const char* name, double v, CompParams& params)
+{
+    auto lin = [](double v, double min, double max) { return Plain2Norm(LIMIT(v, min, max), min, max); };
+    auto log = [](double v, double min, double max) { return LogPlain2Norm(LIMIT(v, min, max), min, max); };
+
+    if      (!std::strcmp(name, "--threshold")) params.pThreshold = lin(v, minThreshold, maxThreshold);
+    else if (!std::strcmp(name, "--ratio"))     params.pRatio     = lin(v, minRatio,     maxRatio);
+    else if (!std::strcmp(name, "--knee"))      params.pKnee      = lin(v, minKnee,      maxKnee);
+    else if (!std::strcmp(name, "--attack"))    params.pAttack    = log(v, minAttack,    maxAttack);
+    else if (!std::strcmp(name, "--release"))   params.pRelease   = lin(v, minRelease,   maxRelease);
+    else if (!std::strcmp(name, "--rms-peak"))  params.pRMS_PEAK  = lin(v, minRMS_PEAK,  maxRMS_PEAK);
+    else if (!std::strcmp(name, "--input"))     params.pInput     = lin(v, minInput,     maxInput);
+    else if (!std::strcmp(name, "--output"))    params.pOutput    = lin(v, minOutput,    maxOutput);
+    else if (!std::strcmp(name, "--makeup"))    params.pMakeup    = lin(v, minMakeup,    maxMakeup);
+    else if (!std::strcmp(name, "--mix"))       params.pMix       = lin(v, minMix,       maxMix);
+    else if (!std::strcmp(name, "--anticipate")) params.pAnticipate = v > 0.5;
+    else return false;
+    return true;
+}
+
+inline void printParamOptions(FILE* out, bool withOutputStage)
+{
+    std::fprintf(out,
+        "  --threshold <dB>    %6.1f .. %5.1f  (default %.1f)\n"
+        "  --ratio <n>         %6.1f .. %5.1f  (default %.1f)\n"
+        "  --knee <dB>         %6.1f .. %5.1f  (default %.1f)\n"
+        "  --attack <ms>       %6.1f .. %5.1f  (default %.1f)\n"
+        "  --release <ms>      %6.1f .. %5.1f  (default %.1f)\n"
+        "  --rms-peak <%%>      %6.1f .. %5.1f  (default %.1f)\n"
+        "  --input <dB>        %6.1f .. %5.1f  (default %.1f)\n"
+        "  --anticipate <0|1>  peak detection across the lookahead (default 0)\n",
+        minThreshold, maxThreshold, dftThreshold,
+        minRatio,     maxRatio,     dftRatio,
+        minKnee,      maxKnee,      dftKnee,
+        minAttack,    maxAttack,    dftAttack,
+        minRelease,   maxRelease,   dftRelease,
+        minRMS_PEAK,  maxRMS_PEAK,  dftRMS_PEAK,
+        minInput,     maxInput,     dftInput);
+    if (withOutputStage)
+        std::fprintf(out,
+            "  --makeup <dB>       %6.1f .. %5.1f  (default %.1f)\n"
+            "  --mix <%%>           %6.1f .. %5.1f  (default %.1f)\n"
+            "  --output <dB>       %6.1f .. %5.1f  (default %.1f)\n",
+            minMakeup,    maxMakeup,    dftMakeup,
+            minMix,       maxMix,       dftMix,
+            minOutput,    maxOutput,    dftOutput);
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
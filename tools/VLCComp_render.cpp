@@ -0,0 +1,328 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+//  vlccomp_render
+//  Batch offline rendering: compresses many WAV files with the same
+//  settings, one file per task on a work stealing pool across all cores,
+//  and reports the aggregate throughput. With --segment, long files are
+//  also cut into pieces rendered in parallel, each warmed up over a
+//  pre-roll before its cut; --check reports how far the detector then is
+//  from a sequential run at the cuts. --quality picks the detector a
+//  realtime playback or an offline bounce gets, --compare reports how far
+//  apart the two land on every file.
+//
+//  vlccomp_render [options] -o <outdir> input.wav... | --list <file>
+//------------------------------------------------------------------------
+
+#include "VLCComp_options.h"
+#include "VLCComp_renderer.h"
+#include "VLCComp_taskpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+//------------------------------------------------------------------------
+void usage()
+{
+    std::fprintf(stderr, "usage: vlccomp_render [options] -o <outdir> input.wav... | --list <file>\n");
+    printParamOptions(stderr, true);
+    std::fprintf(stderr,
+        "  -j <n>              worker threads (default: all cores)\n"
+        "  --block <frames>    processing block size (default 4096)\n"
+        "  --list <file>       read input paths from a file, one per line\n"
+        "  --segment <s>       cut files longer than twice this into segments\n"
+        "  --check             with --segment, measure the deviation at the cuts\n"
+        "  --quality <q>       realtime (default, as the plugin plays back) or offline (as a host bounces)\n"
+        "  --compare           measure how far realtime and offline renders are apart\n"
+        "outputs keep the input file name and format, latency compensated\n");
+}
+
+struct Job
+{
+    std::string in;
+    std::string out = {};   // jobs are brace initialized from in alone
+    uint64_t    bytes = 0;
+    uint64_t    first = 0, count = 0;   // frames, segments only
+    uint64_t    preroll   = 0;
+    bool        segment   = false;
+    std::string error = {};
+    bool        ok = false;
+};
+
+struct Cut
+{
+    std::string in;
+    uint64_t    segmentFrames = 0, preroll = 0;
+    double      gainDb = 0.0, envDb = 0.0;
+    std::string error = {};
+    bool        ok = false;
+};
+
+struct Compare
+{
+    std::string in;
+    double      gainDb = 0.0, outDb = 0.0;
+    std::string error = {};
+    bool        ok = false;
+};
+
+std::string baseName(const std::string& path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+uint64_t fileSize(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? uint64_t(st.st_size) : 0;
+}
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    CompParams  params;
+    int         numWorkers = TaskPool::defaultWorkers();
+    int32       blockSize  = 4096;
+    double      segmentSeconds = 0.0;
+    bool        check      = false;
+    bool        compare    = false;
+    CompressorCore::Quality quality = CompressorCore::kRealtime;
+    std::string outDir;
+    std::vector<Job> jobs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool  hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "-o") && hasValue)
+            outDir = argv[++i];
+        else if (!std::strcmp(arg, "-j") && hasValue)
+            numWorkers = std::max(std::atoi(argv[++i]), 1);
+        else if (!std::strcmp(arg, "--block") && hasValue)
+            blockSize = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--segment") && hasValue)
+            segmentSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(arg, "--check"))
+            check = true;
+        else if (!std::strcmp(arg, "--compare"))
+            compare = true;
+        else if (!std::strcmp(arg, "--quality") && hasValue)
+        {
+            const char* value = argv[++i];
+            if (!std::strcmp(value, "realtime"))
+                quality = CompressorCore::kRealtime;
+            else if (!std::strcmp(value, "offline"))
+                quality = CompressorCore::kOffline;
+            else
+            {
+                usage();
+                return 2;
+            }
+        }
+        else if (!std::strcmp(arg, "--list") && hasValue)
+        {
+            std::ifstream list(argv[++i]);
+            if (!list)
+            {
+                std::fprintf(stderr, "vlccomp_render: cannot read list %s\n", argv[i]);
+                return 2;
+            }
+            for (std::string line; std::getline(list, line);)
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!line.empty())
+                    jobs.push_back({line});
+            }
+        }
+        else if (arg[0] == '-' && arg[1] == '-' && hasValue)
+        {
+            if (!parseParamOption(arg, std::atof(argv[++i]), params))
+            {
+                usage();
+                return 2;
+            }
+        }
+        else if (arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            jobs.push_back({arg});
+    }
+    if (outDir.empty() || jobs.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    const size_t numFiles = jobs.size();
+    std::vector<Compare> compares;
+    for (auto& job : jobs)
+    {
+        job.out   = outDir + "/" + baseName(job.in);
+        job.bytes = fileSize(job.in);
+        if (compare)
+            compares.push_back({job.in});
+    }
+
+    // long files: the output is allocated here, then every segment
+    // fills its own range of it
+    std::vector<Job>  segments;
+    std::vector<Cut>  cuts;
+    FileRenderer      planner(params, blockSize, quality);
+    for (auto& job : jobs)
+    {
+        WavReader probe;
+        if (segmentSeconds <= 0.0 || job.out == job.in || !probe.open(job.in.c_str()))
+            continue;
+        const uint64_t frames  = probe.getFrames();
+        const uint64_t length  = static_cast<uint64_t>(segmentSeconds * probe.getSampleRate());
+        if (length == 0 || frames <= 2 * length)
+            continue;
+        if (!WavWriter::allocate(job.out.c_str(), probe.getChannels(), probe.getSampleRate(), probe.getBitsPerSample(),
+                                 probe.isFloatFormat(), frames))
+            continue; // renders whole, and reports the error then
+        const uint64_t preroll = planner.warmUpFrames(probe.getSampleRate());
+        for (uint64_t first = 0; first < frames; first += length)
+        {
+            Job part    = job;
+            part.first  = first;
+            part.count  = std::min(length, frames - first);
+            part.bytes  = job.bytes / frames * (part.count + std::min(preroll, first));
+            part.preroll = preroll;
+            part.segment = true;
+            segments.push_back(part);
+        }
+        if (check)
+            cuts.push_back({job.in, length, preroll});
+        job.in.clear(); // replaced by its segments
+    }
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const Job& job) { return job.in.empty(); }), jobs.end());
+    jobs.insert(jobs.end(), segments.begin(), segments.end());
+
+    // biggest first, so the long files don't end up alone at the end
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.bytes > b.bytes; });
+
+    TaskPool pool(std::min<int>(numWorkers, static_cast<int>(jobs.size())));
+
+    // one renderer per worker, created on first use by its own thread
+    std::vector<std::unique_ptr<FileRenderer>> renderers(pool.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    pool.run(jobs.size(), [&](size_t index, int worker) {
+        auto& renderer = renderers[worker];
+        if (!renderer)
+            renderer.reset(new FileRenderer(params, blockSize, quality));
+
+        Job& job = jobs[index];
+        if (job.out == job.in)
+            job.error = "output would overwrite the input";
+        else if (job.segment)
+            job.ok = renderer->renderSegment(job.in.c_str(), job.out.c_str(), job.first, job.count, job.preroll, job.error);
+        else
+            job.ok = renderer->render(job.in.c_str(), job.out.c_str(), job.error);
+    });
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> failedFiles;
+    uint64_t frames  = 0;
+    double   seconds = 0.0;
+    for (const auto& job : jobs)
+    {
+        if (!job.ok)
+        {
+            if (job.segment)
+                std::fprintf(stderr, "vlccomp_render: %s [%llu, +%llu]: %s\n", job.in.c_str(),
+                             static_cast<unsigned long long>(job.first), static_cast<unsigned long long>(job.count),
+                             job.error.c_str());
+            else
+                std::fprintf(stderr, "vlccomp_render: %s: %s\n", job.in.c_str(), job.error.c_str());
+            if (std::find(failedFiles.begin(), failedFiles.end(), job.in) == failedFiles.end())
+                failedFiles.push_back(job.in);
+        }
+    }
+    for (const auto& renderer : renderers)
+    {
+        if (renderer)
+        {
+            frames  += renderer->getFramesRendered();
+            seconds += renderer->getSecondsRendered();
+        }
+    }
+
+    const int failed = static_cast<int>(failedFiles.size());
+    std::fprintf(stderr,
+        "%d files in %d tasks (%d failed) on %d threads: %.1f s of audio in %.2f s, %.0fx realtime, %.1f Mframes/s\n",
+        static_cast<int>(numFiles), static_cast<int>(jobs.size()), failed, pool.size(), seconds, wall,
+        wall > 0.0 ? seconds / wall : 0.0, wall > 0.0 ? frames / wall * 1e-6 : 0.0);
+
+    if (!cuts.empty())
+    {
+        pool.run(cuts.size(), [&](size_t index, int worker) {
+            auto& renderer = renderers[worker];
+            if (!renderer)
+                renderer.reset(new FileRenderer(params, blockSize, quality));
+
+            Cut& cut = cuts[index];
+            cut.ok = renderer->measureCuts(cut.in.c_str(), cut.segmentFrames, cut.preroll,
+                                                    cut.gainDb, cut.envDb, cut.error);
+        });
+        double gainDb = 0.0, envDb = 0.0;
+        for (const auto& cut : cuts)
+        {
+            if (!cut.ok)
+            {
+                std::fprintf(stderr, "vlccomp_render: check %s: %s\n", cut.in.c_str(), cut.error.c_str());
+                continue;
+            }
+            std::fprintf(stderr, "  %s: pre-roll %llu frames, at the cuts gain within %.3g dB, envelope within %.3g dB\n",
+                         cut.in.c_str(), static_cast<unsigned long long>(cut.preroll), cut.gainDb, cut.envDb);
+            gainDb = std::max(gainDb, cut.gainDb);
+            envDb  = std::max(envDb, cut.envDb);
+        }
+        std::fprintf(stderr, "segment cuts: gain within %.3g dB, envelope within %.3g dB of a sequential render\n",
+                     gainDb, envDb);
+    }
+
+    if (!compares.empty())
+    {
+        pool.run(compares.size(), [&](size_t index, int worker) {
+            auto& renderer = renderers[worker];
+            if (!renderer)
+                renderer.reset(new FileRenderer(params, blockSize, quality));
+
+            Compare& cmp = compares[index];
+            cmp.ok = renderer->measureQuality(cmp.in.c_str(), cmp.gainDb, cmp.outDb, cmp.error);
+        });
+        double gainDb = 0.0, outDb = gainToDecibels(0.0);
+        for (const auto& cmp : compares)
+        {
+            if (!cmp.ok)
+            {
+                std::fprintf(stderr, "vlccomp_render: compare %s: %s\n", cmp.in.c_str(), cmp.error.c_str());
+                continue;
+            }
+            std::fprintf(stderr, "  %s: gain within %.3g dB, output within %.1f dBFS\n",
+                         cmp.in.c_str(), cmp.gainDb, cmp.outDb);
+            gainDb = std::max(gainDb, cmp.gainDb);
+            outDb  = std::max(outDb, cmp.outDb);
+        }
+        std::fprintf(stderr, "realtime vs offline: gain within %.3g dB, output within %.1f dBFS\n", gainDb, outDb);
+    }
+    return failed ? 1 : 0;
+}
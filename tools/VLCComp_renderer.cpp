@@ -0,0 +1,293 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_renderer.h"
+#include "VLCComp_denormal.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// Channel 0's gain on every frame, appended block after block
+struct GainTap
+{
+    std::vector<DspSample>& gains;
+    void detector(DspSample /*f_env*/, DspSample /*f_gain*/) {}
+    void sample(int32 ch, double /*in*/, double /*out*/, DspSample f_gain)
+    {
+        if (ch == 0)
+            gains.push_back(f_gain);
+    }
+};
+} // namespace
+
+//------------------------------------------------------------------------
+// FileRenderer
+//------------------------------------------------------------------------
+FileRenderer::FileRenderer(const CompParams& params, int32 blockSize, CompressorCore::Quality quality)
+    : params(params)
+    , blockSize(std::max<int32>(blockSize, 64))
+    , quality(quality)
+{}
+
+//------------------------------------------------------------------------
+void FileRenderer::resize(int32 numChannels)
+{
+    // only ever grows, the next file usually has the same layout
+    const size_t needed = size_t(blockSize) * numChannels;
+    if (inBuffer.size() < needed)
+    {
+        inBuffer.resize(needed);
+        outBuffer.resize(needed);
+    }
+    inputs.resize(numChannels);
+    outputs.resize(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+    {
+        inputs[ch]  = inBuffer.data()  + size_t(ch) * blockSize;
+        outputs[ch] = outBuffer.data() + size_t(ch) * blockSize;
+    }
+}
+
+//------------------------------------------------------------------------
+uint64_t FileRenderer::warmUpFrames(double sampleRate)
+{
+    params.prepare(sampleRate);
+    return CompressorCore::warmUpSamples(sampleRate, params);
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::openInput(const char* inPath, std::string& error)
+{
+    if (!reader.open(inPath))
+    {
+        error = "cannot read (PCM 16/24/32 or float 32/64 WAV)";
+        return false;
+    }
+    const int32  numChannels = reader.getChannels();
+    const double SR          = reader.getSampleRate();
+    if (numChannels > AOUT_CHAN_MAX)
+    {
+        error = "more than " + std::to_string(AOUT_CHAN_MAX) + " channels";
+        reader.close();
+        return false;
+    }
+    if (!core.setup(SR, numChannels, quality))
+    {
+        error = "out of memory";
+        reader.close();
+        return false;
+    }
+    params.prepare(SR); // cached, free unless the rate changed
+    core.updateCurve(params);
+    resize(numChannels);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::render(const char* inPath, const char* outPath, std::string& error)
+{
+    if (!openInput(inPath, error))
+        return false;
+
+    if (!writer.open(outPath, reader.getChannels(), reader.getSampleRate(), reader.getBitsPerSample(), reader.isFloatFormat()))
+    {
+        error = std::string("cannot write ") + outPath;
+        reader.close();
+        return false;
+    }
+    const bool ok = run(0, reader.getFrames(), 0, error);
+    if (!writer.close() && ok)
+    {
+        error = std::string("write failed on ") + outPath;
+        return false;
+    }
+    return ok;
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::renderSegment(const char* inPath, const char* outPath, uint64_t first, uint64_t count,
+                                 uint64_t preroll, std::string& error)
+{
+    if (!openInput(inPath, error))
+        return false;
+
+    if (!writer.openAt(outPath, reader.getChannels(), reader.getBitsPerSample(), reader.isFloatFormat(), first))
+    {
+        error = std::string("cannot write ") + outPath;
+        reader.close();
+        return false;
+    }
+    const bool ok = run(first, count, preroll, error);
+    if (!writer.close() && ok)
+    {
+        error = std::string("write failed on ") + outPath;
+        return false;
+    }
+    return ok;
+}
+
+//------------------------------------------------------------------------
+void FileRenderer::warmUp(CompressorCore& target, WavReader& source, uint64_t from, uint64_t to)
+{
+    // the every-4 gain computer steps land where a run from 0 has them
+    target.reset(from);
+    source.seek(from);
+    for (uint64_t pos = from; pos < to;)
+    {
+        const int32 n = source.read(inputs.data(), static_cast<int32>(std::min<uint64_t>(to - pos, uint64_t(blockSize))));
+        if (n == 0)
+            break;
+        target.warmUp(inputs.data(), source.getChannels(), n, params);
+        pos += n;
+    }
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::run(uint64_t first, uint64_t count, uint64_t preroll, std::string& error)
+{
+    const int32  numChannels = reader.getChannels();
+    const double SR          = reader.getSampleRate();
+    DenormalGuard denormalGuard;   // the whole render: a pool thread's, not a host's
+
+    warmUp(core, reader, first - std::min(preroll, first), first);
+
+    // the first latency frames out belong before first: drop them, and
+    // read as far past the range, silence past the end of the file
+    const uint32 latency = CompressorCore::latencySamples(SR);
+    uint32   skip    = latency;
+    uint64_t left    = count + latency;
+    bool     written = true;
+    while (left > 0)
+    {
+        const int32 n   = static_cast<int32>(std::min<uint64_t>(left, uint64_t(blockSize)));
+        const int32 got = reader.read(inputs.data(), n);
+        for (auto* in : inputs)
+            std::fill(in + got, in + n, 0.0);
+
+        core.process(inputs.data(), outputs.data(), numChannels, n, params, noObserver);
+        left -= n;
+
+        const int32 skipped = static_cast<int32>(std::min<uint32>(skip, uint32(n)));
+        skip -= skipped;
+        if (skipped < n)
+        {
+            const double* out[AOUT_CHAN_MAX];
+            for (int32 ch = 0; ch < numChannels; ch++)
+                out[ch] = outputs[ch] + skipped;
+            written = writer.write(out, n - skipped) && written;
+        }
+    }
+    reader.close();
+
+    if (!written)
+    {
+        error = "write failed";
+        return false;
+    }
+    framesRendered  += count;
+    secondsRendered += count / SR;
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::measureCuts(const char* inPath, uint64_t segmentFrames, uint64_t preroll,
+                               double& maxGainDb, double& maxEnvDb, std::string& error)
+{
+    maxGainDb = 0.0;
+    maxEnvDb  = 0.0;
+    if (!openInput(inPath, error))
+        return false;
+    if (!probeReader.open(inPath) || !probe.setup(reader.getSampleRate(), reader.getChannels(), quality))
+    {
+        error = "cannot open a second time";
+        reader.close();
+        return false;
+    }
+    probe.updateCurve(params);
+
+    // detector only on the sequential side, it's the gain that carries over
+    const int32    numChannels = reader.getChannels();
+    const uint64_t frames      = reader.getFrames();
+    DenormalGuard  denormalGuard;
+    CompressorCore::State sequential, warmed;
+    uint64_t pos = 0;
+    core.reset(0);
+    for (uint64_t cut = segmentFrames; cut < frames && segmentFrames > 0; cut += segmentFrames)
+    {
+        while (pos < cut)
+        {
+            const int32 n = reader.read(inputs.data(), static_cast<int32>(std::min<uint64_t>(cut - pos, uint64_t(blockSize))));
+            if (n == 0)
+                break;
+            core.analyze(inputs.data(), numChannels, n, params, noObserver);
+            pos += n;
+        }
+        core.snapshot(sequential);
+
+        warmUp(probe, probeReader, cut - std::min(preroll, cut), cut);
+        probe.snapshot(warmed);
+
+        maxGainDb = std::max(maxGainDb, std::abs(gainToDecibels(sequential.f_gain) - gainToDecibels(warmed.f_gain)));
+        maxEnvDb  = std::max(maxEnvDb,  std::abs(gainToDecibels(sequential.f_env)  - gainToDecibels(warmed.f_env)));
+    }
+    reader.close();
+    probeReader.close();
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool FileRenderer::measureQuality(const char* inPath, double& maxGainDb, double& maxOutDb, std::string& error)
+{
+    maxGainDb = 0.0;
+    maxOutDb  = gainToDecibels(0.0);
+    if (!openInput(inPath, error))
+        return false;
+    const CompressorCore::Quality other =
+        quality == CompressorCore::kOffline ? CompressorCore::kRealtime : CompressorCore::kOffline;
+    const int32 numChannels = reader.getChannels();
+    if (!probe.setup(reader.getSampleRate(), numChannels, other))
+    {
+        error = "out of memory";
+        reader.close();
+        return false;
+    }
+    probe.updateCurve(params);
+
+    probeBuffer.resize(size_t(blockSize) * numChannels);
+    probeOutputs.resize(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+        probeOutputs[ch] = probeBuffer.data() + size_t(ch) * blockSize;
+    gainTrace.reserve(blockSize);
+    probeTrace.reserve(blockSize);
+
+    // same latency either way, the outputs line up frame for frame
+    GainTap tap{gainTrace}, probeTap{probeTrace};
+    double  maxOut = 0.0;
+    DenormalGuard denormalGuard;
+    for (;;)
+    {
+        const int32 n = reader.read(inputs.data(), blockSize);
+        if (n == 0)
+            break;
+        gainTrace.clear();
+        probeTrace.clear();
+        core.process(inputs.data(), outputs.data(), numChannels, n, params, tap);
+        probe.process(inputs.data(), probeOutputs.data(), numChannels, n, params, probeTap);
+
+        for (size_t i = 0; i < gainTrace.size() && i < probeTrace.size(); i++)
+            maxGainDb = std::max(maxGainDb, std::abs(gainToDecibels(gainTrace[i]) - gainToDecibels(probeTrace[i])));
+        for (int32 ch = 0; ch < numChannels; ch++)
+            for (int32 i = 0; i < n; i++)
+                maxOut = std::max(maxOut, std::abs(outputs[ch][i] - probeOutputs[ch][i]));
+    }
+    reader.close();
+    maxOutDb = gainToDecibels(maxOut);
+    return true;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
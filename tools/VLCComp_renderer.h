@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "VLCComp_core.h"
+#include "VLCComp_wavfile.h"
+
+#include <string>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  FileRenderer
+//  Compresses one WAV file into another through CompressorCore, streaming
+//  in fixed blocks. The output is latency compensated, same length and
+//  format as the input. One per worker thread: the core, the file
+//  handles and the block buffers are kept and reused from file to file.
+//
+//  Long files can be cut into segments rendered independently: each one
+//  starts from silence a pre-roll before its cut and warms the core up
+//  over it, then writes its range into a file made with
+//  WavWriter::allocate(). measureCuts() tells how far that lands from a
+//  sequential render.
+//
+//  Renders at CompressorCore::kRealtime by default, what the plugin plays
+//  back; kOffline is what a host's offline bounce gets. measureQuality()
+//  tells how far apart the two land.
+//------------------------------------------------------------------------
+class FileRenderer
+{
+public:
+    explicit FileRenderer(const CompParams& params, int32 blockSize = 4096,
+                          CompressorCore::Quality quality = CompressorCore::kRealtime);
+
+    /** Renders inPath to outPath; on failure says why in error. */
+    bool render(const char* inPath, const char* outPath, std::string& error);
+
+    /** Renders frames [first, first + count) of inPath into the allocated
+     *  outPath, after warming up over up to preroll frames before first. */
+    bool renderSegment(const char* inPath, const char* outPath, uint64_t first, uint64_t count, uint64_t preroll,
+                       std::string& error);
+
+    /** Pre-roll that brings the envelopes within -120 dB at this rate. */
+    uint64_t warmUpFrames(double sampleRate);
+
+    /** Detector state at every segment cut, sequential against warmed up:
+     *  the largest difference of the gain and of the envelope, in dB. */
+    bool measureCuts(const char* inPath, uint64_t segmentFrames, uint64_t preroll,
+                     double& maxGainDb, double& maxEnvDb, std::string& error);
+
+    /** This quality against the other one over the whole file: the
+     *  largest difference of channel 0's gain in dB, and of the output
+     *  in dBFS. */
+    bool measureQuality(const char* inPath, double& maxGainDb, double& maxOutDb, std::string& error);
+
+    uint64_t getFramesRendered() const { return framesRendered; }   // all files so far
+    double   getSecondsRendered() const { return secondsRendered; } // of audio
+
+private:
+    bool openInput(const char* inPath, std::string& error);
+    bool run(uint64_t first, uint64_t count, uint64_t preroll, std::string& error);
+    void warmUp(CompressorCore& target, WavReader& source, uint64_t from, uint64_t to);
+    void resize(int32 numChannels);
+
+    CompressorCore core;
+    CompressorCore probe;       // second core for measureCuts() and measureQuality()
+    CompressorCore::NullObserver noObserver;
+    CompParams     params;
+    int32          blockSize;
+    CompressorCore::Quality quality;
+
+    WavReader reader, probeReader;
+    WavWriter writer;
+    std::vector<double>  inBuffer, outBuffer, probeBuffer;
+    std::vector<double*> inputs, outputs, probeOutputs;
+    std::vector<DspSample> gainTrace, probeTrace;  // measureQuality(), one block
+
+    uint64_t framesRendered  = 0;
+    double   secondsRendered = 0.0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,524 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+//  vlccomp_stress
+//  Many instances on many threads, the way a host's worker pool runs them:
+//  n compressors allocated back to back, each processed by its own thread
+//  in host sized blocks, for n = 1, 2, 4 ... up to -j. If instances shared
+//  cache lines the per-thread throughput would drop as n grows; with the
+//  hot state on lines of its own the scaling stays flat, up to what the
+//  cores and the memory bus give. Every thread feeds the same signal, so
+//  all instances must end in the same state, which is checked too.
+//
+//  With --lanes n it times n mono streams on one thread instead: a
+//  CompressorCore per stream, then LaneCompressor on every lane engine
+//  the CPU runs, W streams per instruction sequence.
+//
+//  With --decay it times one instance through a second of noise and the
+//  silence after it, once without a DenormalGuard and once with one: the
+//  envelopes decay through the subnormal range there.
+//
+//  With --automation it times one instance in 32 frame blocks with the
+//  host resending every parameter each block, unchanged or moving, the
+//  way the processor takes them: prepare() only on a real change.
+//
+//  vlccomp_stress [options]
+//------------------------------------------------------------------------
+
+#include "VLCComp_denormal.h"
+#include "VLCComp_lanes.h"
+#include "VLCComp_options.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+//------------------------------------------------------------------------
+void usage()
+{
+    std::fprintf(stderr, "usage: vlccomp_stress [options]\n");
+    printParamOptions(stderr, true);
+    std::fprintf(stderr,
+        "  -j <n>              most threads and instances (default: all cores)\n"
+        "  --seconds <s>       audio per instance (default 600, 10 with --lanes, 180 with --decay,\n"
+        "                      60 with --automation)\n"
+        "  --block <frames>    processing block size (default 256, 32 with --automation)\n"
+        "  --channels <n>      channels per instance (default 2)\n"
+        "  --rate <Hz>         sample rate (default 48000)\n"
+        "  --lanes <n>         n mono streams on one thread, cores against lane engines\n"
+        "  --decay             one instance into silence, without and with a DenormalGuard\n"
+        "  --automation        one instance, parameters resent every block, unchanged or moving\n");
+}
+
+struct Run
+{
+    double    seconds = 0.0;   // wall clock of this thread
+    DspSample gain    = 0.0;   // where the instance ended
+    double    sum     = 0.0;   // keeps the output alive
+};
+
+// One second of noise, the same for every thread
+void fillNoise(std::vector<double>& buffer)
+{
+    uint32_t seed = 0x2545F491;
+    for (double& x : buffer)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        x = (static_cast<double>(seed >> 8) / double(1 << 24) - 0.5) * 0.8;
+    }
+}
+
+void runInstance(CompressorCore& core, const CompParams& params, int32 numChannels, int32 blockSize,
+                 uint64_t totalFrames, double SR, const std::atomic<bool>& go, Run& run)
+{
+    // allocated by the thread that uses them, as a host's worker would
+    const size_t period = static_cast<size_t>(SR);
+    std::vector<double> noise(period * numChannels);
+    fillNoise(noise);
+    std::vector<std::vector<double>> in(numChannels, std::vector<double>(blockSize));
+    std::vector<std::vector<double>> out(numChannels, std::vector<double>(blockSize));
+    std::vector<double*> inputs(numChannels), outputs(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+    {
+        inputs[ch]  = in[ch].data();
+        outputs[ch] = out[ch].data();
+    }
+    CompressorCore::NullObserver none;
+
+    while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t pos = 0;
+    double sum = 0.0;   // local: runs[] neighbours would share a line
+    for (uint64_t done = 0; done < totalFrames; done += blockSize)
+    {
+        const int32 frames = static_cast<int32>(std::min<uint64_t>(blockSize, totalFrames - done));
+        for (int32 i = 0; i < frames; i++, pos = (pos + 1) % period)
+            for (int32 ch = 0; ch < numChannels; ch++)
+                in[ch][i] = noise[pos * numChannels + ch];
+
+        core.process(inputs.data(), outputs.data(), numChannels, frames, params, none);
+        sum += outputs[0][frames - 1];
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.gain    = core.getGain();
+    run.sum     = sum;
+}
+
+//------------------------------------------------------------------------
+// Mono streams on this thread: the same noise at a different offset each,
+// read in place so that both sides only pay for the compressor
+class StreamFeed
+{
+public:
+    StreamFeed(int32 numStreams, int32 blockSize, double SR)
+    : period(static_cast<size_t>(SR)), noise(period + blockSize),
+      out(numStreams, std::vector<double>(blockSize)), inputs(numStreams), outputs(numStreams)
+    {
+        fillNoise(noise);
+        for (int32 k = 0; k < numStreams; k++)
+            outputs[k] = out[k].data();
+    }
+
+    double** next(uint64_t done)
+    {
+        for (size_t k = 0; k < inputs.size(); k++)
+            inputs[k] = noise.data() + (done + k * 7919) % period;
+        return inputs.data();
+    }
+    double** result() { return outputs.data(); }
+
+private:
+    size_t period;
+    std::vector<double> noise;
+    std::vector<std::vector<double>> out;
+    std::vector<double*> inputs, outputs;
+};
+
+int runLanes(const CompParams& params, int32 numStreams, int32 blockSize, double seconds, double SR)
+{
+    const uint64_t totalFrames = static_cast<uint64_t>(seconds * SR);
+    std::printf("%d mono streams at %.0f Hz, %d frame blocks, %.0f s each, one thread\n",
+                numStreams, SR, blockSize, seconds);
+    std::printf("engine     width   wall s   realtime streams   speedup\n");
+
+    StreamFeed feed(numStreams, blockSize, SR);
+
+    std::vector<CompressorCore> cores(numStreams);
+    for (CompressorCore& core : cores)
+    {
+        if (!core.setup(SR, 1))
+        {
+            std::fprintf(stderr, "vlccomp_stress: out of memory at %d streams\n", numStreams);
+            return 1;
+        }
+        core.updateCurve(params);
+    }
+    CompressorCore::NullObserver none;
+    DenormalGuard denormalGuard;   // as LaneCompressor takes one
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t done = 0; done < totalFrames; done += blockSize)
+    {
+        const int32 frames = static_cast<int32>(std::min<uint64_t>(blockSize, totalFrames - done));
+        double** inputs  = feed.next(done);
+        double** outputs = feed.result();
+        for (int32 k = 0; k < numStreams; k++)
+            cores[k].process(inputs + k, outputs + k, 1, frames, params, none);
+    }
+    const double coreSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-10s %5d %8.2f %18.0f %8.2fx\n", "core", 1, coreSeconds, numStreams * seconds / coreSeconds, 1.0);
+    cores.clear();
+
+    for (const LaneEngine* engine : LaneCompressor::availableEngines())
+    {
+        LaneCompressor lanes;
+        if (!lanes.setup(SR, numStreams, engine->width))
+        {
+            std::fprintf(stderr, "vlccomp_stress: out of memory at %d streams\n", numStreams);
+            return 1;
+        }
+        lanes.updateCurve(params);
+
+        start = std::chrono::steady_clock::now();
+        for (uint64_t done = 0; done < totalFrames; done += blockSize)
+        {
+            const int32 frames = static_cast<int32>(std::min<uint64_t>(blockSize, totalFrames - done));
+            lanes.process(feed.next(done), feed.result(), frames, params);
+        }
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-10s %5d %8.2f %18.0f %8.2fx\n", engine->name, engine->width, wall, numStreams * seconds / wall,
+                    coreSeconds / wall);
+    }
+    std::printf("realtime streams: how many this thread keeps up with; speedup: over a core per stream\n");
+    return 0;
+}
+
+//------------------------------------------------------------------------
+// Decay to silence: a second of noise, then zeros to the end. Without the
+// guard the release recursions crawl through the subnormal range before
+// they underflow to zero, every frame of it on the slow path.
+struct DecayRun
+{
+    double wall    = 0.0;
+    double slowest = 0.0;   // wall clock of the slowest second
+    int    at      = 0;     // and which one
+};
+
+template <bool Guarded>
+DecayRun runDecayPass(const CompParams& params, int32 numChannels, int32 blockSize, int numSeconds, double SR)
+{
+    const int32 period = static_cast<int32>(SR);
+    std::vector<double> noise(size_t(period) * numChannels);
+    fillNoise(noise);
+    std::vector<std::vector<double>> in(numChannels, std::vector<double>(blockSize));
+    std::vector<std::vector<double>> out(numChannels, std::vector<double>(blockSize));
+    std::vector<double*> inputs(numChannels), outputs(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+    {
+        inputs[ch]  = in[ch].data();
+        outputs[ch] = out[ch].data();
+    }
+
+    DecayRun run;
+    CompressorCore core;
+    if (!core.setup(SR, numChannels))
+        return run;
+    core.updateCurve(params);
+    CompressorCore::NullObserver none;
+
+    for (int second = 0; second < numSeconds; second++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int32 done = 0; done < period; done += blockSize)
+        {
+            const int32 frames = std::min(blockSize, period - done);
+            for (int32 ch = 0; ch < numChannels; ch++)
+                for (int32 i = 0; i < frames; i++)
+                    in[ch][i] = second == 0 ? noise[size_t(done + i) * numChannels + ch] : 0.0;
+
+            if (Guarded)
+            {
+                DenormalGuard denormalGuard;   // per block, as the processor takes it
+                core.process(inputs.data(), outputs.data(), numChannels, frames, params, none);
+            }
+            else
+                core.process(inputs.data(), outputs.data(), numChannels, frames, params, none);
+        }
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.wall += wall;
+        if (wall > run.slowest)
+        {
+            run.slowest = wall;
+            run.at      = second;
+        }
+    }
+    return run;
+}
+
+int runDecay(const CompParams& params, int32 numChannels, int32 blockSize, double seconds, double SR)
+{
+    const int numSeconds = std::max(static_cast<int>(seconds), 2);
+    std::printf("1 s of noise, then %d s of silence; %d channels at %.0f Hz, %d frame blocks, release %.0f ms\n",
+                numSeconds - 1, numChannels, SR, blockSize, Norm2Plain(params.pRelease, minRelease, maxRelease));
+    std::printf("guard   wall s   x realtime   slowest second   x realtime there\n");
+
+    const DecayRun runs[] = { runDecayPass<false>(params, numChannels, blockSize, numSeconds, SR),
+                              runDecayPass<true>(params, numChannels, blockSize, numSeconds, SR) };
+    for (int guarded = 0; guarded < 2; guarded++)
+    {
+        const DecayRun& run = runs[guarded];
+        if (run.wall <= 0.0)
+        {
+            std::fprintf(stderr, "vlccomp_stress: out of memory\n");
+            return 1;
+        }
+        std::printf("%-5s %8.2f %12.1f %15ds %18.1f\n", guarded ? "on" : "off",
+                    run.wall, numSeconds / run.wall, run.at, 1.0 / run.slowest);
+    }
+    std::printf("slowest second: of the audio, counted from the start; off against on is the subnormal cost\n");
+    return 0;
+}
+
+//------------------------------------------------------------------------
+// Automation: what the host sends every block. Every parameter each time,
+// most hosts do; the moving ones alternate between two values, so every
+// block is a real change. Threshold, knee and ratio hold still, a curve
+// change is the builder thread's work and out of this picture.
+enum class Moves { kNone, kAttack, kAllButCurve };
+
+double runAutomationPass(CompParams params, Moves moves, int32 numChannels, int32 blockSize,
+                         uint64_t totalFrames, double SR)
+{
+    const size_t period = static_cast<size_t>(SR);
+    std::vector<double> noise(period * numChannels);
+    fillNoise(noise);
+    std::vector<std::vector<double>> in(numChannels, std::vector<double>(blockSize));
+    std::vector<std::vector<double>> out(numChannels, std::vector<double>(blockSize));
+    std::vector<double*> inputs(numChannels), outputs(numChannels);
+    for (int32 ch = 0; ch < numChannels; ch++)
+    {
+        inputs[ch]  = in[ch].data();
+        outputs[ch] = out[ch].data();
+    }
+
+    CompressorCore core;
+    if (!core.setup(SR, numChannels))
+        return 0.0;
+    params.prepare(SR);
+    core.updateCurve(params);
+    CompressorCore::NullObserver none;
+    DenormalGuard denormalGuard;
+
+    const CompParams base = params;
+    const auto nudge = [](ParamValue v) { return v < 0.5 ? v + 0.01 : v - 0.01; };
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t   pos   = 0;
+    uint64_t block = 0;
+    for (uint64_t done = 0; done < totalFrames; done += blockSize, block++)
+    {
+        const int32 frames = static_cast<int32>(std::min<uint64_t>(blockSize, totalFrames - done));
+        for (int32 i = 0; i < frames; i++, pos = (pos + 1) % period)
+            for (int32 ch = 0; ch < numChannels; ch++)
+                in[ch][i] = noise[pos * numChannels + ch];
+
+        // as VLC_CompProcessor::applyParamChanges() takes them
+        const bool moved = (block & 1) != 0;
+        const bool all   = moved && moves == Moves::kAllButCurve;
+        bool changed = false;
+        const auto set = [&changed](ParamValue& dst, ParamValue value)
+        {
+            if (dst != value)
+            {
+                dst     = value;
+                changed = true;
+            }
+        };
+        set(params.pInput,     all ? nudge(base.pInput) : base.pInput);
+        set(params.pOutput,    all ? nudge(base.pOutput) : base.pOutput);
+        set(params.pRMS_PEAK,  all ? nudge(base.pRMS_PEAK) : base.pRMS_PEAK);
+        set(params.pAttack,    moved && moves != Moves::kNone ? nudge(base.pAttack) : base.pAttack);
+        set(params.pRelease,   all ? nudge(base.pRelease) : base.pRelease);
+        set(params.pThreshold, base.pThreshold);
+        set(params.pRatio,     base.pRatio);
+        set(params.pKnee,      base.pKnee);
+        set(params.pMakeup,    all ? nudge(base.pMakeup) : base.pMakeup);
+        set(params.pMix,       all ? nudge(base.pMix) : base.pMix);
+        if (changed)
+            params.prepare(SR);
+
+        core.process(inputs.data(), outputs.data(), numChannels, frames, params, none);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runAutomation(const CompParams& params, int32 numChannels, int32 blockSize, double seconds, double SR)
+{
+    const uint64_t totalFrames = static_cast<uint64_t>(seconds * SR);
+    const double   numBlocks   = std::ceil(static_cast<double>(totalFrames) / blockSize);
+    std::printf("%d channels at %.0f Hz, %d frame blocks, %.0f s each, parameters resent every block\n",
+                numChannels, SR, blockSize, seconds);
+    std::printf("moving            wall s   x realtime   ns per block\n");
+
+    const struct { const char* name; Moves moves; } passes[] = {
+        { "nothing",        Moves::kNone },
+        { "attack",         Moves::kAttack },
+        { "all but curve",  Moves::kAllButCurve },
+    };
+    for (const auto& pass : passes)
+    {
+        const double wall = runAutomationPass(params, pass.moves, numChannels, blockSize, totalFrames, SR);
+        if (wall <= 0.0)
+        {
+            std::fprintf(stderr, "vlccomp_stress: out of memory\n");
+            return 1;
+        }
+        std::printf("%-15s %8.2f %12.1f %14.0f\n", pass.name, wall, seconds / wall, 1e9 * wall / numBlocks);
+    }
+    std::printf("moving: a new value every block; threshold, knee and ratio never move, the curve table holds\n");
+    return 0;
+}
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    CompParams params;
+    int        maxThreads  = std::max<int>(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    double     seconds     = 600.0;
+    bool       secondsGiven = false;
+    int32      blockSize   = 256;
+    int32      numChannels = 2;
+    double     SR          = 48000.0;
+    int32      numStreams  = 0;
+    bool       decay       = false;
+    bool       automation  = false;
+    bool       blockGiven  = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool  hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "-j") && hasValue)
+            maxThreads = std::max(std::atoi(argv[++i]), 1);
+        else if (!std::strcmp(arg, "--seconds") && hasValue)
+        {
+            seconds      = std::atof(argv[++i]);
+            secondsGiven = true;
+        }
+        else if (!std::strcmp(arg, "--block") && hasValue)
+        {
+            blockSize  = std::atoi(argv[++i]);
+            blockGiven = true;
+        }
+        else if (!std::strcmp(arg, "--channels") && hasValue)
+            numChannels = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--rate") && hasValue)
+            SR = std::atof(argv[++i]);
+        else if (!std::strcmp(arg, "--lanes") && hasValue)
+            numStreams = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--decay"))
+            decay = true;
+        else if (!std::strcmp(arg, "--automation"))
+            automation = true;
+        else if (arg[0] == '-' && arg[1] == '-' && hasValue)
+        {
+            if (!parseParamOption(arg, std::atof(argv[++i]), params))
+            {
+                usage();
+                return 2;
+            }
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (seconds <= 0.0 || blockSize <= 0 || numChannels <= 0 || numChannels > AOUT_CHAN_MAX || SR <= 0.0
+        || numStreams < 0)
+    {
+        usage();
+        return 2;
+    }
+    params.prepare(SR);
+
+    if (numStreams > 0)
+        return runLanes(params, numStreams, blockSize, secondsGiven ? seconds : 10.0, SR);
+    if (decay)
+        return runDecay(params, numChannels, blockSize, secondsGiven ? seconds : 180.0, SR);
+    if (automation)
+        return runAutomation(params, numChannels, blockGiven ? blockSize : 32, secondsGiven ? seconds : 60.0, SR);
+
+    const uint64_t totalFrames = static_cast<uint64_t>(seconds * SR);
+    std::printf("%d channels at %.0f Hz, %d frame blocks, %.0f s per instance; core %zu bytes, aligned to %zu\n",
+                numChannels, SR, blockSize, seconds, sizeof(CompressorCore), alignof(CompressorCore));
+    std::printf("threads   wall s   x realtime each   x realtime total   scaling   bytes each   state\n");
+
+    std::vector<int> counts;
+    for (int n = 1; n < maxThreads; n *= 2)
+        counts.push_back(n);
+    counts.push_back(maxThreads);
+
+    double single = 0.0;   // x realtime of one instance alone
+    bool   allSame = true;
+    for (int n : counts)
+    {
+        // back to back, neighbours as close as a host's allocator may put them
+        std::unique_ptr<CompressorCore[]> cores(new CompressorCore[n]);
+        for (int k = 0; k < n; k++)
+        {
+            if (!cores[k].setup(SR, numChannels))
+            {
+                std::fprintf(stderr, "vlccomp_stress: out of memory at %d instances\n", n);
+                return 1;
+            }
+            cores[k].updateCurve(params);
+        }
+
+        std::vector<Run> runs(n);
+        std::vector<std::thread> threads;
+        std::atomic<bool> go {false};
+        threads.reserve(n);
+        for (int k = 0; k < n; k++)
+            threads.emplace_back(runInstance, std::ref(cores[k]), std::cref(params), numChannels, blockSize,
+                                 totalFrames, SR, std::cref(go), std::ref(runs[k]));
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& t : threads)
+            t.join();
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double slowest = 0.0;
+        bool   same    = true;
+        for (const Run& run : runs)
+        {
+            slowest = std::max(slowest, run.seconds);
+            same    = same && run.gain == runs[0].gain && run.sum == runs[0].sum;
+        }
+        allSame = allSame && same;
+
+        const double each  = seconds / slowest;
+        const double total = seconds * n / wall;
+        if (n == 1)
+            single = each;
+        std::printf("%7d %8.2f %17.1f %18.1f %8.0f%% %12zu   %s\n",
+                    n, wall, each, total, 100.0 * total / (single * n), sizeof(CompressorCore) + cores[0].footprint(),
+                    same ? "identical" : "DIFFERENT");
+    }
+    std::printf("scaling: total throughput over threads x one instance alone, 100%% is linear\n");
+    std::printf("bytes each: sizeof(CompressorCore) plus footprint(), the heap it sized for the rate\n");
+    return allSame ? 0 : 1;
+}
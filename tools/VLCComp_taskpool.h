@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  TaskPool
+//  Work stealing over a fixed set of independent tasks, one thread per
+//  worker. Tasks are dealt round-robin up front, so list them biggest
+//  first; each worker then takes from the front of its own queue and,
+//  once that is empty, steals from the back of the others. Queues only
+//  meet under contention when a worker runs dry, so with coarse tasks
+//  (whole files, long segments) scaling is limited by memory bandwidth,
+//  not by the pool.
+//------------------------------------------------------------------------
+class TaskPool
+{
+public:
+    explicit TaskPool(int numWorkers)
+        : queues(static_cast<size_t>(std::max(numWorkers, 1)))
+    {}
+
+    int size() const { return static_cast<int>(queues.size()); }
+
+    static int defaultWorkers()
+    {
+        return static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    /** Calls task(index, worker) once for each index in [0, count) and
+     *  returns when all are done. worker is in [0, size()), so per-worker
+     *  scratch can be indexed by it without locking. */
+    template <typename Task>
+    void run(size_t count, Task&& task)
+    {
+        const size_t n = queues.size();
+        for (size_t i = 0; i < count; i++)
+            queues[i % n].items.push_back(i);
+
+        std::vector<std::thread> threads;
+        threads.reserve(n - 1);
+        for (size_t w = 1; w < n; w++)
+            threads.emplace_back([this, w, &task] { work(static_cast<int>(w), task); });
+        work(0, task);
+        for (auto& t : threads)
+            t.join();
+    }
+
+private:
+    struct alignas(64) Queue
+    {
+        std::mutex         lock;
+        std::deque<size_t> items;
+    };
+
+    bool pop(int worker, size_t& index)
+    {
+        {
+            Queue& own = queues[worker];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.items.empty())
+            {
+                index = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        // nothing left of our own, steal the smallest of someone else's
+        const int n = size();
+        for (int k = 1; k < n; k++)
+        {
+            Queue& victim = queues[(worker + k) % n];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.items.empty())
+            {
+                index = victim.items.back();
+                victim.items.pop_back();
+                return true;
+            }
+        }
+        return false; // no task is ever added while running, so we're done
+    }
+
+    template <typename Task>
+    void work(int worker, Task& task)
+    {
+        size_t index;
+        while (pop(worker, index))
+            task(index, worker);
+    }
+
+    std::vector<Queue> queues;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_twin.h"
+
+// Everything below is the core again, the other precision, renamed
+#if VLCCOMP_FLOAT_ENGINE
+#undef  VLCCOMP_FLOAT_ENGINE
+#define VLCCOMP_FLOAT_ENGINE 0
+#else
+#undef  VLCCOMP_FLOAT_ENGINE
+#define VLCCOMP_FLOAT_ENGINE 1
+#endif
+
+#define yg331 yg331_twin
+#include "VLCComp_core.cpp"
+#include "VLCComp_denormal.h"
+#undef yg331
+
+#include <vector>
+
+namespace yg331 {
+namespace twin {
+namespace {
+//------------------------------------------------------------------------
+struct GainTap
+{
+    double* gains;
+    void detector(yg331_twin::DspSample /*f_env*/, yg331_twin::DspSample /*f_gain*/) {}
+    void sample(int32_t ch, double /*in*/, double /*out*/, yg331_twin::DspSample f_gain)
+    {
+        if (ch == 0 && gains)
+            *gains++ = f_gain;
+    }
+};
+} // namespace
+
+//------------------------------------------------------------------------
+const char* precision()
+{
+    return VLCCOMP_FLOAT_ENGINE ? "float" : "double";
+}
+
+//------------------------------------------------------------------------
+bool process(const double* state, double SR, bool offline, double* const* inputs, double* const* outputs,
+             int32_t numChannels, int32_t frames, int32_t blockSize, double* gains)
+{
+    using namespace yg331_twin;
+
+    StateValues values;
+    for (uint32 id = 0; id < kNumParams; id++)
+        values.set(id, state[id]);
+    CompParams params;
+    params.fromState(values);
+    params.prepare(SR);
+
+    CompressorCore core;
+    if (!core.setup(SR, numChannels, offline ? CompressorCore::kOffline : CompressorCore::kRealtime))
+        return false;
+    core.updateCurve(params);
+
+    DenormalGuard denormalGuard;
+    GainTap tap{gains};
+    std::vector<double*> in(numChannels), out(numChannels);
+    for (int32_t done = 0; done < frames; done += blockSize)
+    {
+        const int32_t n = std::min(blockSize, frames - done);
+        for (int32_t ch = 0; ch < numChannels; ch++)
+        {
+            in[ch]  = inputs[ch] + done;
+            out[ch] = outputs[ch] + done;
+        }
+        core.process(in.data(), out.data(), numChannels, n, params, tap);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+} // namespace twin
+} // namespace yg331
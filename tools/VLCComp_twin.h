@@ -0,0 +1,31 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+
+namespace yg331 {
+namespace twin {
+//------------------------------------------------------------------------
+//  The compressor in the other precision: CompressorCore compiled again
+//  from the same sources under a namespace of its own, with DspSample
+//  float in a double build and double in a VLCCOMP_FLOAT_ENGINE one, so
+//  vlccomp_check can hold this build's engine against it. Plain types
+//  only here, the twin's own CompParams and core never meet this build's.
+//------------------------------------------------------------------------
+
+/** "float" or "double", the twin's DspSample. */
+const char* precision();
+
+/** Compresses frames of planar audio through a fresh twin core in blocks
+ *  of blockSize, settings as normalized values in StateValues order
+ *  (kNumParams of them). gains, if given, gets channel 0's gain for
+ *  every frame. False if the core couldn't be set up. */
+bool process(const double* state, double SR, bool offline, double* const* inputs, double* const* outputs,
+             int32_t numChannels, int32_t frames, int32_t blockSize, double* gains);
+
+//------------------------------------------------------------------------
+} // namespace twin
+} // namespace yg331
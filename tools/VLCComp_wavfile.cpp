@@ -0,0 +1,618 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "VLCComp_wavfile.h"
+#include "VLCComp_shared.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VLCCOMP_WAV_MMAP 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VLCCOMP_WAV_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#define VLCCOMP_WAV_NEON 1
+#endif
+
+namespace yg331 {
+namespace {
+//------------------------------------------------------------------------
+// RIFF is little endian whatever the host is
+uint32_t le16(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8); }
+uint32_t le32(const uint8_t* p) { return le16(p) | (le16(p + 2) << 16); }
+
+void put16(uint8_t* p, uint32_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+constexpr uint32_t kFormatPCM        = 1;
+constexpr uint32_t kFormatFloat      = 3;
+constexpr uint32_t kFormatExtensible = 0xFFFE;
+
+//------------------------------------------------------------------------
+// Sample conversion. The vector paths cover the common layouts (mono and
+// stereo, float 32 and PCM 16) and return how many frames they did, the
+// scalar loop does the rest and every other format.
+//------------------------------------------------------------------------
+double decodeSample(const uint8_t* p, int32_t bytesPer, bool isFloat)
+{
+    if (isFloat)
+    {
+        if (bytesPer == 4)
+        {
+            uint32_t bits = le32(p);
+            float f;
+            std::memcpy(&f, &bits, 4);
+            return f;
+        }
+        uint64_t bits = uint64_t(le32(p)) | (uint64_t(le32(p + 4)) << 32);
+        double v;
+        std::memcpy(&v, &bits, 8);
+        return v;
+    }
+    if (bytesPer == 2)
+        return int16_t(le16(p)) / 32768.0;
+    if (bytesPer == 3)
+        return int32_t((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24)) / 2147483648.0;
+    return int32_t(le32(p)) / 2147483648.0;
+}
+
+void encodeSample(uint8_t* p, double v, int32_t bytesPer, bool isFloat)
+{
+    if (isFloat)
+    {
+        if (bytesPer == 4)
+        {
+            const float f = static_cast<float>(v);
+            uint32_t bits;
+            std::memcpy(&bits, &f, 4);
+            put32(p, bits);
+        }
+        else
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &v, 8);
+            put32(p, uint32_t(bits));
+            put32(p + 4, uint32_t(bits >> 32));
+        }
+        return;
+    }
+    const double c = LIMIT(v, -1.0, 1.0);
+    if (bytesPer == 2)
+    {
+        put16(p, uint32_t(int32_t(std::lrint(std::min(c * 32768.0, 32767.0)))));
+        return;
+    }
+    const int32_t s = int32_t(std::llrint(std::min(c * 2147483648.0, 2147483647.0)));
+    if (bytesPer == 3)
+    {
+        p[0] = uint8_t(uint32_t(s) >> 8);
+        p[1] = uint8_t(uint32_t(s) >> 16);
+        p[2] = uint8_t(uint32_t(s) >> 24);
+    }
+    else
+        put32(p, uint32_t(s));
+}
+
+int32_t decodeVector(const uint8_t* src, double** dst, int32_t n, int32_t channels, int32_t bytesPer, bool isFloat)
+{
+    int32_t i = 0;
+#if VLCCOMP_WAV_SSE2
+    if (isFloat && bytesPer == 4 && channels == 2)
+    {
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m128  v = _mm_loadu_ps(reinterpret_cast<const float*>(src + i * 8)); // L0 R0 L1 R1
+            const __m128d a = _mm_cvtps_pd(v);
+            const __m128d b = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+            _mm_storeu_pd(dst[0] + i, _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(dst[1] + i, _mm_unpackhi_pd(a, b));
+        }
+    }
+    else if (isFloat && bytesPer == 4 && channels == 1)
+    {
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst[0] + i, _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4)))));
+    }
+    else if (!isFloat && bytesPer == 2 && channels == 2)
+    {
+        const __m128d scale = _mm_set1_pd(1.0 / 32768.0);
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)); // L0 R0 .. L3 R3
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            const __m128d a  = _mm_mul_pd(_mm_cvtepi32_pd(lo), scale);
+            const __m128d b  = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(lo, 8)), scale);
+            const __m128d c  = _mm_mul_pd(_mm_cvtepi32_pd(hi), scale);
+            const __m128d d  = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(hi, 8)), scale);
+            _mm_storeu_pd(dst[0] + i,     _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(dst[1] + i,     _mm_unpackhi_pd(a, b));
+            _mm_storeu_pd(dst[0] + i + 2, _mm_unpacklo_pd(c, d));
+            _mm_storeu_pd(dst[1] + i + 2, _mm_unpackhi_pd(c, d));
+        }
+    }
+    else if (!isFloat && bytesPer == 2 && channels == 1)
+    {
+        const __m128d scale = _mm_set1_pd(1.0 / 32768.0);
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 2));
+            const __m128i w = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            _mm_storeu_pd(dst[0] + i,     _mm_mul_pd(_mm_cvtepi32_pd(w), scale));
+            _mm_storeu_pd(dst[0] + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(w, 8)), scale));
+        }
+    }
+#elif VLCCOMP_WAV_NEON
+    if (isFloat && bytesPer == 4 && channels == 2)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            const float32x4x2_t v = vld2q_f32(reinterpret_cast<const float*>(src + i * 8));
+            vst1q_f64(dst[0] + i,     vcvt_f64_f32(vget_low_f32(v.val[0])));
+            vst1q_f64(dst[0] + i + 2, vcvt_high_f64_f32(v.val[0]));
+            vst1q_f64(dst[1] + i,     vcvt_f64_f32(vget_low_f32(v.val[1])));
+            vst1q_f64(dst[1] + i + 2, vcvt_high_f64_f32(v.val[1]));
+        }
+    }
+    else if (isFloat && bytesPer == 4 && channels == 1)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            const float32x4_t v = vld1q_f32(reinterpret_cast<const float*>(src + i * 4));
+            vst1q_f64(dst[0] + i,     vcvt_f64_f32(vget_low_f32(v)));
+            vst1q_f64(dst[0] + i + 2, vcvt_high_f64_f32(v));
+        }
+    }
+#else
+    (void)src; (void)dst; (void)n; (void)channels; (void)bytesPer; (void)isFloat;
+#endif
+    return i;
+}
+
+int32_t encodeVector(const double* const* src, uint8_t* dst, int32_t n, int32_t channels, int32_t bytesPer, bool isFloat)
+{
+    int32_t i = 0;
+#if VLCCOMP_WAV_SSE2
+    if (isFloat && bytesPer == 4 && channels == 2)
+    {
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m128d l = _mm_loadu_pd(src[0] + i);
+            const __m128d r = _mm_loadu_pd(src[1] + i);
+            const __m128  a = _mm_cvtpd_ps(_mm_unpacklo_pd(l, r));
+            const __m128  b = _mm_cvtpd_ps(_mm_unpackhi_pd(l, r));
+            _mm_storeu_ps(reinterpret_cast<float*>(dst + i * 8), _mm_movelh_ps(a, b));
+        }
+    }
+    else if (!isFloat && bytesPer == 2 && (channels == 1 || channels == 2))
+    {
+        // same clip and round to nearest as encodeSample
+        const __m128d lo    = _mm_set1_pd(-1.0);
+        const __m128d hi    = _mm_set1_pd(1.0);
+        const __m128d scale = _mm_set1_pd(32768.0);
+        const __m128d top   = _mm_set1_pd(32767.0);
+        auto quantize = [&](__m128d v) {
+            return _mm_cvtpd_epi32(_mm_min_pd(_mm_mul_pd(_mm_min_pd(_mm_max_pd(v, lo), hi), scale), top));
+        };
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m128d l = _mm_loadu_pd(src[0] + i);
+            __m128i s;
+            if (channels == 2)
+            {
+                const __m128d r = _mm_loadu_pd(src[1] + i);
+                s = _mm_unpacklo_epi64(quantize(_mm_unpacklo_pd(l, r)), quantize(_mm_unpackhi_pd(l, r)));
+            }
+            else
+                s = quantize(l);
+            const __m128i packed = _mm_packs_epi32(s, s);
+            if (channels == 2)
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 4), packed);
+            else
+            {
+                const int32_t two = _mm_cvtsi128_si32(packed);
+                std::memcpy(dst + i * 2, &two, 4);
+            }
+        }
+    }
+#elif VLCCOMP_WAV_NEON
+    if (isFloat && bytesPer == 4 && channels == 2)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4x2_t v;
+            v.val[0] = vcombine_f32(vcvt_f32_f64(vld1q_f64(src[0] + i)), vcvt_f32_f64(vld1q_f64(src[0] + i + 2)));
+            v.val[1] = vcombine_f32(vcvt_f32_f64(vld1q_f64(src[1] + i)), vcvt_f32_f64(vld1q_f64(src[1] + i + 2)));
+            vst2q_f32(reinterpret_cast<float*>(dst + i * 8), v);
+        }
+    }
+#else
+    (void)src; (void)dst; (void)n; (void)channels; (void)bytesPer; (void)isFloat;
+#endif
+    return i;
+}
+
+void decode(const uint8_t* src, double** dst, int32_t n, int32_t channels, int32_t bytesPer, bool isFloat)
+{
+    int32_t i = decodeVector(src, dst, n, channels, bytesPer, isFloat);
+    for (const uint8_t* p = src + size_t(i) * channels * bytesPer; i < n; i++)
+        for (int32_t ch = 0; ch < channels; ch++, p += bytesPer)
+            dst[ch][i] = decodeSample(p, bytesPer, isFloat);
+}
+
+void encode(const double* const* src, uint8_t* dst, int32_t n, int32_t channels, int32_t bytesPer, bool isFloat)
+{
+    int32_t i = encodeVector(src, dst, n, channels, bytesPer, isFloat);
+    for (uint8_t* p = dst + size_t(i) * channels * bytesPer; i < n; i++)
+        for (int32_t ch = 0; ch < channels; ch++, p += bytesPer)
+            encodeSample(p, src[ch][i], bytesPer, isFloat);
+}
+} // namespace
+
+//------------------------------------------------------------------------
+// WavReader
+//------------------------------------------------------------------------
+bool WavReader::open(const char* path)
+{
+    close();
+    file = std::fopen(path, "rb");
+    if (!file)
+        return false;
+
+    uint8_t riff[12];
+    if (std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        close();
+        return false;
+    }
+
+    bool haveFormat = false;
+    uint8_t chunk[8];
+    while (std::fread(chunk, 1, 8, file) == 8)
+    {
+        const uint32_t size = le32(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+        {
+            std::vector<uint8_t> fmt(size);
+            if (std::fread(fmt.data(), 1, size, file) != size)
+                break;
+            uint32_t tag = le16(&fmt[0]);
+            if (tag == kFormatExtensible && size >= 26)
+                tag = le16(&fmt[24]); // first two bytes of the sub format GUID
+            channels   = static_cast<int32_t>(le16(&fmt[2]));
+            sampleRate = static_cast<double>(le32(&fmt[4]));
+            bytesPer   = static_cast<int32_t>(le16(&fmt[14]) / 8);
+            isFloat    = (tag == kFormatFloat);
+            haveFormat = (tag == kFormatPCM     && (bytesPer == 2 || bytesPer == 3 || bytesPer == 4))
+                      || (tag == kFormatFloat   && (bytesPer == 4 || bytesPer == 8));
+            haveFormat = haveFormat && channels > 0 && sampleRate > 0.0;
+            if (size & 1)
+                std::fseek(file, 1, SEEK_CUR);
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+                break;
+            dataOffset = static_cast<uint64_t>(std::ftell(file));
+            frames     = size / (uint64_t(bytesPer) * channels);
+            map(); // or read() falls back to fread
+            framesLeft = frames;
+            return true;
+        }
+        else if (std::fseek(file, long(size + (size & 1)), SEEK_CUR) != 0)
+        {
+            break;
+        }
+    }
+    close();
+    return false;
+}
+
+//------------------------------------------------------------------------
+void WavReader::close()
+{
+    unmap();
+    if (file)
+        std::fclose(file);
+    file       = nullptr;
+    frames     = 0;
+    framesLeft = 0;
+}
+
+//------------------------------------------------------------------------
+bool WavReader::map()
+{
+#if VLCCOMP_WAV_MMAP
+    struct stat st;
+    const int fd = fileno(file);
+    if (fstat(fd, &st) != 0 || uint64_t(st.st_size) <= dataOffset)
+        return false;
+
+    // a truncated file just has fewer frames than its header says
+    const uint64_t frameBytes = uint64_t(bytesPer) * channels;
+    frames = std::min<uint64_t>(frames, (uint64_t(st.st_size) - dataOffset) / frameBytes);
+    const uint64_t size = dataOffset + frames * frameBytes;
+    if (size != uint64_t(size_t(size)))
+        return false; // doesn't fit the address space, read instead
+
+    void* p = mmap(nullptr, size_t(size), PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return false;
+    madvise(p, size_t(size), MADV_SEQUENTIAL);
+
+    mapped     = static_cast<uint8_t*>(p);
+    mappedSize = size;
+    position   = dataOffset;
+    released   = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------
+void WavReader::unmap()
+{
+#if VLCCOMP_WAV_MMAP
+    if (mapped)
+        munmap(mapped, size_t(mappedSize));
+#endif
+    mapped     = nullptr;
+    mappedSize = 0;
+}
+
+//------------------------------------------------------------------------
+int32_t WavReader::read(double** outputs, int32_t maxFrames)
+{
+    if (!file || maxFrames <= 0 || framesLeft == 0)
+        return 0;
+
+    const size_t  frameBytes = size_t(bytesPer) * channels;
+    const int32_t wanted     = static_cast<int32_t>(std::min<uint64_t>(uint64_t(maxFrames), framesLeft));
+
+    if (mapped)
+    {
+        decode(mapped + position, outputs, wanted, channels, bytesPer, isFloat);
+        position   += uint64_t(wanted) * frameBytes;
+        framesLeft -= wanted;
+#if VLCCOMP_WAV_MMAP
+        // hand back what we're done with, it would otherwise stay resident
+        if (position - released >= kReleaseBytes)
+        {
+            const uint64_t page = uint64_t(sysconf(_SC_PAGESIZE));
+            const uint64_t end  = position & ~(page - 1);
+            madvise(mapped + released, size_t(end - released), MADV_DONTNEED);
+            released = end;
+        }
+#endif
+        return wanted;
+    }
+
+    raw.resize(size_t(wanted) * frameBytes);
+    const int32_t got = static_cast<int32_t>(std::fread(raw.data(), frameBytes, size_t(wanted), file));
+    framesLeft = (got < wanted) ? 0 : framesLeft - got;
+    decode(raw.data(), outputs, got, channels, bytesPer, isFloat);
+    return got;
+}
+
+//------------------------------------------------------------------------
+bool WavReader::seek(uint64_t frame)
+{
+    if (!file || frame > frames)
+        return false;
+
+    const uint64_t offset = dataOffset + frame * uint64_t(bytesPer) * channels;
+    if (mapped)
+    {
+        position = offset;
+#if VLCCOMP_WAV_MMAP
+        released = offset & ~(uint64_t(sysconf(_SC_PAGESIZE)) - 1);
+#endif
+    }
+    else if (std::fseek(file, long(offset), SEEK_SET) != 0)
+        return false;
+
+    framesLeft = frames - frame;
+    return true;
+}
+
+//------------------------------------------------------------------------
+// WavWriter
+//------------------------------------------------------------------------
+WavWriter::~WavWriter()
+{
+    close();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    if (io.joinable())
+        io.join();
+}
+
+//------------------------------------------------------------------------
+void WavWriter::header(uint8_t* out, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat,
+                       uint64_t dataBytes)
+{
+    // RIFF sizes are 32 bit, files past 4 GB keep the clamped value like most writers do
+    const uint32_t data = uint32_t(std::min<uint64_t>(dataBytes, 0xFFFFFFFFu - 36));
+    const int32_t  bytesPer = bitsPerSample / 8;
+
+    std::memset(out, 0, 44);
+    std::memcpy(out, "RIFF", 4);
+    put32(out + 4, data + 36 + uint32_t(dataBytes & 1));
+    std::memcpy(out + 8, "WAVEfmt ", 8);
+    put32(out + 16, 16);
+    put16(out + 20, floatFormat ? kFormatFloat : kFormatPCM);
+    put16(out + 22, uint32_t(numChannels));
+    put32(out + 24, uint32_t(sampleRate));
+    put32(out + 28, uint32_t(sampleRate) * numChannels * bytesPer);
+    put16(out + 32, uint32_t(numChannels * bytesPer));
+    put16(out + 34, uint32_t(bitsPerSample));
+    std::memcpy(out + 36, "data", 4);
+    put32(out + 40, data);
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::start(const char* path, const char* mode, int32_t numChannels, int32_t bitsPerSample, bool floatFormat)
+{
+    close();
+    const int32_t bytes = bitsPerSample / 8;
+    const bool supported = floatFormat ? (bytes == 4 || bytes == 8) : (bytes == 2 || bytes == 3 || bytes == 4);
+    if (!supported || numChannels <= 0)
+        return false;
+
+    file = std::fopen(path, mode);
+    if (!file)
+        return false;
+
+    channels  = numChannels;
+    bytesPer  = bytes;
+    isFloat   = floatFormat;
+    failed    = false;
+    dataBytes = 0;
+
+    if (!io.joinable())
+        io = std::thread([this] { ioLoop(); });
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::open(const char* path, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat)
+{
+    if (!start(path, "wb", numChannels, bitsPerSample, floatFormat))
+        return false;
+    isPart = false;
+
+    // sizes are patched by close()
+    uint8_t head[44];
+    header(head, numChannels, sampleRate, bitsPerSample, floatFormat, 0);
+    failed = std::fwrite(head, 1, 44, file) != 44;
+    return !failed;
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::allocate(const char* path, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat,
+                         uint64_t numFrames)
+{
+    FILE* f = std::fopen(path, "wb");
+    if (!f)
+        return false;
+
+    const uint64_t bytes = numFrames * numChannels * uint64_t(bitsPerSample / 8);
+    uint8_t head[44];
+    header(head, numChannels, sampleRate, bitsPerSample, floatFormat, bytes);
+    bool ok = std::fwrite(head, 1, 44, f) == 44;
+
+    // sparse where the file system allows, the parts fill it in
+    const uint64_t last = 44 + bytes + (bytes & 1) - 1;
+    if (ok && last >= 44)
+        ok = std::fseek(f, long(last), SEEK_SET) == 0 && std::fputc(0, f) != EOF;
+    return (std::fclose(f) == 0) && ok;
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::openAt(const char* path, int32_t numChannels, int32_t bitsPerSample, bool floatFormat, uint64_t firstFrame)
+{
+    if (!start(path, "r+b", numChannels, bitsPerSample, floatFormat))
+        return false;
+    isPart = true;
+
+    const uint64_t offset = 44 + firstFrame * uint64_t(channels) * bytesPer;
+    failed = std::fseek(file, long(offset), SEEK_SET) != 0;
+    return !failed;
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::write(const double* const* inputs, int32_t numFrames)
+{
+    if (!file || numFrames <= 0)
+        return file != nullptr;
+
+    // the io thread only ever touches the other buffer
+    std::vector<uint8_t>& buffer = buffers[back];
+    buffer.resize(size_t(numFrames) * channels * bytesPer);
+    encode(inputs, buffer.data(), numFrames, channels, bytesPer, isFloat);
+    dataBytes += buffer.size();
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        waitIdle(guard);
+        if (failed)
+            return false;
+        back ^= 1;
+        pending = true;
+    }
+    wake.notify_all();
+    return true;
+}
+
+//------------------------------------------------------------------------
+void WavWriter::waitIdle(std::unique_lock<std::mutex>& guard)
+{
+    wake.wait(guard, [this] { return !pending; });
+}
+
+//------------------------------------------------------------------------
+void WavWriter::ioLoop()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        wake.wait(guard, [this] { return pending || quit; });
+        if (!pending)
+            return;
+
+        const std::vector<uint8_t>& buffer = buffers[1 - back];
+        FILE* f = file;
+        guard.unlock();
+        const bool ok = std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+        guard.lock();
+
+        failed  = failed || !ok;
+        pending = false;
+        wake.notify_all();
+    }
+}
+
+//------------------------------------------------------------------------
+bool WavWriter::close()
+{
+    if (!file)
+        return !failed;
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        waitIdle(guard);
+    }
+
+    if (!isPart)
+    {
+        uint8_t head[44];
+        header(head, channels, 0.0, bytesPer * 8, isFloat, dataBytes);
+        if (dataBytes & 1)
+            std::fputc(0, file);
+        std::fseek(file, 4, SEEK_SET);
+        std::fwrite(head + 4, 1, 4, file);
+        std::fseek(file, 40, SEEK_SET);
+        std::fwrite(head + 40, 1, 4, file);
+    }
+    if (std::fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
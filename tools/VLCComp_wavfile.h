@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yg331 {
+//------------------------------------------------------------------------
+//  WavReader
+//  Streaming reader for RIFF/WAVE files: PCM 16/24/32 bit and IEEE float
+//  32/64 bit, plain or WAVE_FORMAT_EXTENSIBLE. Reads blocks straight into
+//  planar double buffers, so a file of any length runs in fixed memory.
+//
+//  On POSIX the data chunk is memory mapped and decoded in place, pages
+//  already consumed are handed back to the kernel every kReleaseBytes so
+//  resident memory stays flat however long the file. Elsewhere, or when
+//  the mapping fails, it falls back to one large read per block.
+//------------------------------------------------------------------------
+class WavReader
+{
+public:
+    WavReader() = default;
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+    ~WavReader() { close(); }
+
+    /** Opens and parses the header; false if missing or not a supported format. */
+    bool open(const char* path);
+    void close();
+
+    int32_t  getChannels() const { return channels; }
+    double   getSampleRate() const { return sampleRate; }
+    uint64_t getFrames() const { return frames; }
+    int32_t  getBitsPerSample() const { return bytesPer * 8; }
+    bool     isFloatFormat() const { return isFloat; }
+    bool     isMapped() const { return mapped != nullptr; }
+
+    /** Reads up to maxFrames into outputs[channel][frame], returns the frames read. */
+    int32_t read(double** outputs, int32_t maxFrames);
+
+    /** Moves the next read() to frame; false past the end. */
+    bool seek(uint64_t frame);
+
+private:
+    static constexpr uint64_t kReleaseBytes = 8u << 20;
+
+    bool map();
+    void unmap();
+
+    FILE*    file       = nullptr;
+    int32_t  channels   = 0;
+    int32_t  bytesPer   = 0;      // per sample
+    bool     isFloat    = false;
+    double   sampleRate = 0.0;
+    uint64_t frames     = 0;
+    uint64_t framesLeft = 0;
+    uint64_t dataOffset = 0;      // of the data chunk in the file
+
+    // memory mapped data chunk
+    uint8_t* mapped      = nullptr;
+    uint64_t mappedSize  = 0;     // whole mapping, from file offset 0
+    uint64_t position    = 0;     // next byte to decode
+    uint64_t released    = 0;     // bytes below this were given back
+
+    std::vector<uint8_t> raw;     // read() fallback
+};
+
+//------------------------------------------------------------------------
+//  WavWriter
+//  Streaming counterpart of WavReader: PCM 16/24/32 bit or float 32/64 bit
+//  from planar double buffers. PCM is clipped, not wrapped. The sizes in
+//  the header are filled in by close().
+//
+//  Writes are double buffered: write() encodes into one buffer while a
+//  writer thread owned by the object puts the previous one on disk, so
+//  the caller's DSP overlaps the I/O. The thread is started by the first
+//  open() and kept until destruction, so reusing one writer across files
+//  costs no thread churn.
+//------------------------------------------------------------------------
+class WavWriter
+{
+public:
+    WavWriter() = default;
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+    ~WavWriter();
+
+    bool open(const char* path, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat);
+
+    /** Creates a file with its final header and size up front, so that
+     *  several writers can fill it in parallel through openAt(). */
+    static bool allocate(const char* path, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat,
+                         uint64_t numFrames);
+    /** Opens an allocate()d file to write from firstFrame on; close() then
+     *  leaves the header alone. */
+    bool openAt(const char* path, int32_t numChannels, int32_t bitsPerSample, bool floatFormat, uint64_t firstFrame);
+
+    /** Queues numFrames; false once any earlier write failed. */
+    bool write(const double* const* inputs, int32_t numFrames);
+    /** Waits for the queue, finishes the header; false if anything failed to reach the disk. */
+    bool close();
+
+private:
+    static void header(uint8_t* out, int32_t numChannels, double sampleRate, int32_t bitsPerSample, bool floatFormat,
+                       uint64_t dataBytes);
+    bool start(const char* path, const char* mode, int32_t numChannels, int32_t bitsPerSample, bool floatFormat);
+    void ioLoop();
+    void waitIdle(std::unique_lock<std::mutex>& guard);
+
+    FILE*    file     = nullptr;
+    int32_t  channels = 0;
+    int32_t  bytesPer = 0;
+    bool     isFloat  = false;
+    bool     isPart   = false;      // opened with openAt()
+    uint64_t dataBytes = 0;
+
+    std::vector<uint8_t> buffers[2];
+    int back = 0;                       // the one write() encodes into
+
+    std::thread             io;
+    std::mutex              lock;
+    std::condition_variable wake;
+    bool pending = false;               // buffers[1 - back] is queued for the io thread
+    bool failed  = false;
+    bool quit    = false;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331